@@ -0,0 +1,275 @@
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+
+// Converts every OBJ model of a directory into the binary mesh format the game maps at startup:
+//     DigDugII.Cooker.exe [models directory] [output directory]
+// The import flags match Model so a cooked model draws exactly like an imported one, and the meshes go
+// through the same merge and MeshOptimizer stage before they are written.
+
+struct CookedMesh
+{
+    std::vector<MeshFile::Vertex> vertices;
+    std::vector<unsigned int> indices;
+    MeshFile::Entry entry;
+};
+
+static std::vector<std::string> ListModels(const std::string &directory)
+{
+    std::vector<std::string> names;
+#ifdef _WIN32
+    WIN32_FIND_DATAA found;
+    HANDLE search = FindFirstFileA((directory + "*.obj").c_str(), &found);
+    if(search != INVALID_HANDLE_VALUE)
+    {
+        do
+        {
+            names.push_back(found.cFileName);
+        }
+        while(FindNextFileA(search, &found));
+        FindClose(search);
+    }
+#else
+    DIR *listing = opendir(directory.c_str());
+    if(listing != nullptr)
+    {
+        while(dirent *found = readdir(listing))
+        {
+            std::string name(found->d_name);
+            if(name.size() > 4 && name.compare(name.size() - 4, 4, ".obj") == 0)
+            {
+                names.push_back(name);
+            }
+        }
+        closedir(listing);
+    }
+#endif
+    return names;
+}
+
+static void CreateOutputDirectory(const std::string &directory)
+{
+    // An existing directory is fine, writing the first model reports any other failure
+#ifdef _WIN32
+    CreateDirectoryA(directory.c_str(), nullptr);
+#else
+    mkdir(directory.c_str(), 0755);
+#endif
+}
+
+static void CopyTexturePath(aiMaterial *material, aiTextureType type, char *path)
+{
+    std::memset(path, 0, MeshFile::PathLength);
+
+    aiString texturePath;
+    if(material->GetTextureCount(type) == 0 || material->GetTexture(type, 0, &texturePath) != AI_SUCCESS)
+    {
+        return;
+    }
+
+    if(texturePath.length >= (unsigned int)MeshFile::PathLength)
+    {
+        std::cerr << "ERROR::COOKER::TEXTURE_PATH_TOO_LONG " << texturePath.C_Str() << std::endl;
+        return;
+    }
+
+    std::memcpy(path, texturePath.C_Str(), texturePath.length);
+}
+
+static void CookNode(aiNode *node, const aiScene *scene, std::vector<CookedMesh> *meshes)
+{
+    for(unsigned int i = 0; i < node->mNumMeshes; ++i)
+    {
+        aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
+        CookedMesh cooked;
+
+        for(unsigned int j = 0; j < mesh->mNumVertices; ++j)
+        {
+            MeshFile::Vertex vertex;
+            vertex.position = glm::vec3(mesh->mVertices[j].x, mesh->mVertices[j].y, mesh->mVertices[j].z);
+            vertex.normal = glm::vec3(mesh->mNormals[j].x, mesh->mNormals[j].y, mesh->mNormals[j].z);
+            vertex.texCoords = mesh->mTextureCoords[0] ? glm::vec2(mesh->mTextureCoords[0][j].x, mesh->mTextureCoords[0][j].y) : glm::vec2(0.0f);
+            // The texture array is built at runtime, the loader fills the layer in
+            vertex.layer = -1.0f;
+            cooked.vertices.push_back(vertex);
+        }
+
+        for(unsigned int j = 0; j < mesh->mNumFaces; ++j)
+        {
+            for(unsigned int k = 0; k < mesh->mFaces[j].mNumIndices; ++k)
+            {
+                cooked.indices.push_back(mesh->mFaces[j].mIndices[k]);
+            }
+        }
+
+        aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];
+        CopyTexturePath(material, aiTextureType_DIFFUSE, cooked.entry.diffuseTexture);
+        CopyTexturePath(material, aiTextureType_SPECULAR, cooked.entry.specularTexture);
+
+        meshes->push_back(cooked);
+    }
+
+    for(unsigned int i = 0; i < node->mNumChildren; ++i)
+    {
+        CookNode(node->mChildren[i], scene, meshes);
+    }
+}
+
+static void OptimizeMeshes(std::vector<CookedMesh> *meshes)
+{
+    // Meshes with the same texture paths are merged, as Model does for the runtime import
+    std::vector<CookedMesh> merged;
+    for(CookedMesh &mesh : *meshes)
+    {
+        CookedMesh *target = nullptr;
+        for(CookedMesh &candidate : merged)
+        {
+            if(std::strncmp(candidate.entry.diffuseTexture, mesh.entry.diffuseTexture, MeshFile::PathLength) == 0 &&
+               std::strncmp(candidate.entry.specularTexture, mesh.entry.specularTexture, MeshFile::PathLength) == 0)
+            {
+                target = &candidate;
+                break;
+            }
+        }
+
+        if(target == nullptr)
+        {
+            merged.push_back(mesh);
+            continue;
+        }
+
+        unsigned int offset = (unsigned int)target->vertices.size();
+        target->vertices.insert(target->vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+        for(unsigned int index : mesh.indices)
+        {
+            target->indices.push_back(index + offset);
+        }
+    }
+
+    for(CookedMesh &mesh : merged)
+    {
+        MeshOptimizer::Optimize(mesh.vertices, mesh.indices);
+    }
+    meshes->swap(merged);
+}
+
+static void CountMeshes(const std::vector<CookedMesh> &meshes, size_t *vertices, float *acmr)
+{
+    size_t triangles = 0;
+    float misses = 0.0f;
+    *vertices = 0;
+    for(const CookedMesh &mesh : meshes)
+    {
+        *vertices += mesh.vertices.size();
+        triangles += mesh.indices.size() / 3;
+        misses += MeshOptimizer::ComputeACMR(mesh.indices, mesh.vertices.size()) * (mesh.indices.size() / 3);
+    }
+    *acmr = triangles > 0 ? misses / triangles : 0.0f;
+}
+
+static bool CookModel(const std::string &source, const std::string &destination)
+{
+    Assimp::Importer import;
+    const aiScene *scene = import.ReadFile(source, aiProcess_Triangulate | aiProcess_FlipUVs);
+    if(!scene || scene->mFlags == AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+    {
+        std::cerr << "ERROR::ASSIMP::" << import.GetErrorString() << std::endl;
+        return false;
+    }
+
+    std::vector<CookedMesh> meshes;
+    CookNode(scene->mRootNode, scene, &meshes);
+
+    size_t meshesBefore = meshes.size();
+    size_t verticesBefore;
+    size_t verticesAfter;
+    float acmrBefore;
+    float acmrAfter;
+    CountMeshes(meshes, &verticesBefore, &acmrBefore);
+    OptimizeMeshes(&meshes);
+    CountMeshes(meshes, &verticesAfter, &acmrAfter);
+
+    // Lay the data out after the header and the mesh table, vertices and indices of a mesh back to back
+    MeshFile::Header header;
+    std::memcpy(header.magic, MeshFile::Magic, sizeof(header.magic));
+    header.version = MeshFile::Version;
+    header.vertexSize = sizeof(MeshFile::Vertex);
+    header.meshCount = (uint32_t)meshes.size();
+    header.model = MeshFile::GetSourceStamp(source);
+    header.material = MeshFile::GetSourceStamp(MeshFile::GetMaterialPath(source));
+
+    uint32_t offset = sizeof(MeshFile::Header) + (uint32_t)(meshes.size() * sizeof(MeshFile::Entry));
+    for(CookedMesh &mesh : meshes)
+    {
+        mesh.entry.vertexOffset = offset;
+        mesh.entry.vertexCount = (uint32_t)mesh.vertices.size();
+        offset += (uint32_t)(mesh.vertices.size() * sizeof(MeshFile::Vertex));
+        mesh.entry.indexOffset = offset;
+        mesh.entry.indexCount = (uint32_t)mesh.indices.size();
+        offset += (uint32_t)(mesh.indices.size() * sizeof(unsigned int));
+    }
+
+    std::ofstream file(destination, std::ios::binary);
+    if(!file)
+    {
+        std::cerr << "ERROR::COOKER::CANNOT_WRITE " << destination << std::endl;
+        return false;
+    }
+
+    file.write((const char*)&header, sizeof(header));
+    for(CookedMesh &mesh : meshes)
+    {
+        file.write((const char*)&mesh.entry, sizeof(mesh.entry));
+    }
+    for(CookedMesh &mesh : meshes)
+    {
+        file.write((const char*)mesh.vertices.data(), mesh.vertices.size() * sizeof(MeshFile::Vertex));
+        file.write((const char*)mesh.indices.data(), mesh.indices.size() * sizeof(unsigned int));
+    }
+
+    std::cout << source << " -> " << destination << ", " << offset << " bytes, meshes " << meshesBefore << " -> " << meshes.size()
+              << ", vertices " << verticesBefore << " -> " << verticesAfter << ", ACMR " << acmrBefore << " -> " << acmrAfter << std::endl;
+    return (bool)file;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string modelDirectory = argc > 1 ? std::string(argv[1]) + "/" : "../Resources/models/";
+    std::string outputDirectory = argc > 2 ? std::string(argv[2]) + "/" : "../Resources/cooked/";
+
+    std::vector<std::string> names = ListModels(modelDirectory);
+    if(names.empty())
+    {
+        std::cerr << "ERROR::COOKER::NO_MODELS " << modelDirectory << std::endl;
+        return 1;
+    }
+
+    CreateOutputDirectory(outputDirectory);
+
+    int failures = 0;
+    for(const std::string &name : names)
+    {
+        std::string cookedName = name.substr(0, name.find_last_of('.')) + MeshFile::Extension;
+        if(!CookModel(modelDirectory + name, outputDirectory + cookedName))
+        {
+            ++failures;
+        }
+    }
+
+    return failures == 0 ? 0 : 1;
+}
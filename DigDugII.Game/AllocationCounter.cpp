@@ -0,0 +1,48 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "AllocationCounter.h"
+
+#ifdef _DEBUG
+
+static std::atomic<unsigned long long> allocationCount(0);
+
+void* operator new(std::size_t size)
+{
+    ++allocationCount;
+    void *memory = std::malloc(size > 0 ? size : 1);
+    if(memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+    std::free(memory);
+}
+
+unsigned long long AllocationCounter::GetCount()
+{
+    return allocationCount;
+}
+
+#else
+
+unsigned long long AllocationCounter::GetCount()
+{
+    return 0;
+}
+
+#endif
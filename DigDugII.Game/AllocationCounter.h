@@ -0,0 +1,8 @@
+#pragma once
+
+// Counts heap allocations made through the global operator new. Only debug builds replace
+// the operator, release builds always report zero.
+namespace AllocationCounter
+{
+    unsigned long long GetCount();
+}
@@ -0,0 +1,90 @@
+#include "AssetLoader.h"
+
+AssetLoader::AssetLoader()
+    : nextModel(0)
+{
+}
+
+AssetLoader::~AssetLoader()
+{
+}
+
+void AssetLoader::Load(const std::vector<Model*> &models, TextureArray *textureArray)
+{
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    this->models = models;
+    timings.assign(models.size(), Timing());
+    nextModel = 0;
+    readyModels.clear();
+
+    int workerCount = (int)std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), std::max<size_t>(1, models.size()));
+    std::vector<std::thread> workers;
+    for(int i = 0; i < workerCount; ++i)
+    {
+        workers.push_back(std::thread(&AssetLoader::work, this, i));
+    }
+
+    // GL calls stay on this thread, it uploads models in the order the workers finish them
+    for(size_t uploaded = 0; uploaded < models.size(); ++uploaded)
+    {
+        size_t index;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            modelReady.wait(lock, [this]() { return !readyModels.empty(); });
+            index = readyModels.front();
+            readyModels.pop_front();
+        }
+
+        std::chrono::high_resolution_clock::time_point uploadStart = std::chrono::high_resolution_clock::now();
+        models[index]->Upload();
+        timings[index].uploadMilliseconds = millisecondsSince(uploadStart);
+    }
+
+    for(std::thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    // Layers are added by every block model, the array can only be uploaded once all of them are loaded
+    double arrayMilliseconds = 0.0;
+    if(textureArray != nullptr)
+    {
+        std::chrono::high_resolution_clock::time_point uploadStart = std::chrono::high_resolution_clock::now();
+        textureArray->Upload();
+        arrayMilliseconds = millisecondsSince(uploadStart);
+    }
+
+    // Prefetched textures no model acquired would otherwise stay decoded for the whole run
+    TextureCache::DiscardPrefetched();
+
+    for(size_t i = 0; i < models.size(); ++i)
+    {
+        std::cout << "GAME::LOAD::MODEL " << models[i]->GetName() << " load " << timings[i].loadMilliseconds
+                  << " ms on worker " << timings[i].worker << ", upload " << timings[i].uploadMilliseconds << " ms" << std::endl;
+    }
+    std::cout << "GAME::LOAD::TEXTURE_ARRAY upload " << arrayMilliseconds << " ms" << std::endl;
+    std::cout << "GAME::LOAD::TOTAL " << models.size() << " models on " << workerCount << " workers in "
+              << millisecondsSince(start) << " ms" << std::endl;
+}
+
+void AssetLoader::work(int worker)
+{
+    for(size_t index = nextModel++; index < models.size(); index = nextModel++)
+    {
+        std::chrono::high_resolution_clock::time_point loadStart = std::chrono::high_resolution_clock::now();
+        models[index]->Load();
+        timings[index].loadMilliseconds = millisecondsSince(loadStart);
+        timings[index].worker = worker;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            readyModels.push_back(index);
+        }
+        modelReady.notify_one();
+    }
+}
+
+double AssetLoader::millisecondsSince(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
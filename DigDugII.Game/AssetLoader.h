@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+#include "Model.h"
+#include "TextureArray.h"
+#include "TextureCache.h"
+
+// Loads models on a pool of worker threads while the GL thread uploads each one as soon as it is ready,
+// so parsing and texture decoding of the remaining models overlaps the uploads. Prints how long every
+// model took to load and to upload once everything is in.
+class AssetLoader
+{
+public:
+    AssetLoader();
+    ~AssetLoader();
+
+    void Load(const std::vector<Model*> &models, TextureArray *textureArray);
+
+private:
+    struct Timing
+    {
+        double loadMilliseconds;
+        double uploadMilliseconds;
+        int worker;
+    };
+
+    std::vector<Model*> models;
+    std::vector<Timing> timings;
+    std::atomic<size_t> nextModel;
+    std::deque<size_t> readyModels;
+    std::mutex mutex;
+    std::condition_variable modelReady;
+
+    void work(int worker);
+    static double millisecondsSince(std::chrono::high_resolution_clock::time_point start);
+};
@@ -1,49 +1,107 @@
 #include "Game.h"
 
-const std::string Game::LevelGroundPath("../Resources/level/level_ground.png");
-const std::string Game::LevelAbovePath("../Resources/level/level_above.png");
-
-Game::Game()
-    : levelGrid(),
-    state(GameState::RUNNING)
+const std::string Game::LevelDirectory("../Resources/level/");
+const std::string Game::LevelGroundFile("level_ground.png");
+const std::string Game::LevelAboveFile("level_above.png");
+Game::TileShape Game::tileShapes[Game::TileShapeCount];
+
+// Speeds in units per second, the original tuning was 0.1 and 0.075 units per frame at 60 frames per second
+const float Game::PlayerSpeed = 6.0f;
+const float Game::EnemySpeed = 4.5f;
+const float Game::PushSpeed = 60.0f;
+const float Game::FallSpeed = 6.0f;
+// A pushed enemy is only stopped by the tile next to the one it is on, so a tick must not carry it further
+// than one 2 unit tile, PushSpeed / 2
+const int Game::MinTickRate = 30;
+// Objects that fell below this height are gone from view and get destroyed
+const float Game::SunkDepth = -15.0f;
+// Longest frame the simulation catches up on, so a stall doesn't turn into a burst of ticks
+const double Game::MaxFrameTime = 0.25;
+// Seconds between two render stats lines while they are switched on
+const double Game::RenderStatsInterval = 1.0;
+
+Game::Game(bool headless, int tickRate, IslandRule islandRule, const std::string &levelDirectory)
+    : levelGroundPath(levelDirectory + LevelGroundFile),
+    levelAbovePath(levelDirectory + LevelAboveFile),
+    levelWidth(0),
+    levelHeight(0),
+    state(GameState::RUNNING),
+    islandRule(islandRule),
+    headless(headless),
+    tickDuration(1.0 / std::max(tickRate, MinTickRate)),
+    window(nullptr),
+    context(nullptr),
+    shader(nullptr),
+    mainCamera(nullptr),
+    camera(nullptr),
+    fpsCamera(nullptr),
+    thirdCamera(nullptr),
+    showRenderStats(false),
+    drawAllocations(0),
+    playerHandle(GameObjectPool::NullHandle)
 {
-    SDL_Init(SDL_INIT_VIDEO);
+    if(!headless)
+    {
+        SDL_Init(SDL_INIT_VIDEO);
 
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+        SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
 
-    SDL_GetDesktopDisplayMode(0, &display);
+        SDL_GetDesktopDisplayMode(0, &display);
 
-    window = SDL_CreateWindow("OpenGL", 100, 100, display.w, display.h, SDL_WINDOW_OPENGL | SDL_WINDOW_FULLSCREEN_DESKTOP);
-    context = SDL_GL_CreateContext(window);
+        window = SDL_CreateWindow("OpenGL", 100, 100, display.w, display.h, SDL_WINDOW_OPENGL | SDL_WINDOW_FULLSCREEN_DESKTOP);
+        context = SDL_GL_CreateContext(window);
 
-    glewExperimental = GL_TRUE;
-    glewInit();
+        glewExperimental = GL_TRUE;
+        glewInit();
 
-    glEnable(GL_DEPTH_TEST);
+        glEnable(GL_DEPTH_TEST);
 
-    shader = new Shader("shader");
+        shader = new Shader("shader");
+
+        LoadModels();
+    }
+    else
+    {
+        // No GL context: blocks only keep their object type, every model slot stays empty
+        models.assign(GameObject::OBJECT_NULL, nullptr);
+    }
 
-    LoadModels();
+    LoadTileShapes();
     LoadLevel();
 
-    camera = new Camera(glm::vec3(20.0, 30.0, 30.0), glm::vec3(20.0, 0.0, 20.0), Camera::NORMAL);
+    // The overview camera and the light are placed from the level size, 20x20 gives the original framing
+    float extent = (float)std::max(levelWidth, levelHeight);
+    camera = new Camera(glm::vec3(levelWidth, extent * 1.5, levelHeight + extent * 0.5), glm::vec3(levelWidth, 0.0, levelHeight), Camera::NORMAL);
     mainCamera = camera;
+
+    if(!headless)
+    {
+        LoadUniforms();
+    }
 }
 
 Game::~Game()
 {
-    SDL_GL_DeleteContext(context);
-    SDL_DestroyWindow(window);
-    SDL_Quit();
+    if(!headless)
+    {
+        // Chunk meshes delete their GL buffers, which needs the context still current
+        levelMesh.Resize(0, 0);
+        SDL_GL_DeleteContext(context);
+        SDL_DestroyWindow(window);
+        SDL_Quit();
+    }
 }
 
 void Game::Run()
 {
     SDL_Event windowEvent;
     bool running = true;
+    double accumulator = 0.0;
+    double statsTime = 0.0;
+    std::chrono::high_resolution_clock::time_point previousTime = std::chrono::high_resolution_clock::now();
     while(running)
     {
         while(SDL_PollEvent(&windowEvent))
@@ -64,106 +122,305 @@ void Game::Run()
                 break;
             }
         }
-        
-        if(state == GameState::RUNNING)
+
+        std::chrono::high_resolution_clock::time_point currentTime = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> frameTime = currentTime - previousTime;
+        previousTime = currentTime;
+
+        accumulator += std::min(frameTime.count(), MaxFrameTime);
+        while(accumulator >= tickDuration)
         {
-            UpdateCamera();
-            UpdateEnemies();
-            Update();
+            Tick();
+            accumulator -= tickDuration;
         }
 
-        glClearColor(0.0f, 0.5f, 0.75f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        glViewport(0, 0, display.w, display.h);
-        // Transformation matrices
-        glm::mat4 projection = glm::perspective(45.0f, (float)display.w / display.h, 0.1f, 100.0f);
-        glm::mat4 view = mainCamera->GetViewMatrix();
-        shader->SetUniform("projection", projection);
-        shader->SetUniform("view", view);
-
-        // Set the lighting uniforms
-        shader->SetUniform("viewPosition", camera->GetEye());
-        shader->SetUniform("lights[0].position", glm::vec3(20.0, 20.0, 20.0));
-        shader->SetUniform("lights[0].ambient", glm::vec3(0.3f, 0.3f, 0.3f));
-        shader->SetUniform("lights[0].diffuse", glm::vec3(1.0f, 1.0f, 1.0f));
-        shader->SetUniform("lights[0].specular", glm::vec3(1.0f, 1.0f, 1.0f));
-        shader->SetUniform("lights[0].constant", 1.0f);
-        shader->SetUniform("lights[0].linear", 0.009f);
-        shader->SetUniform("lights[0].quadratic", 0.0032f);
-
-        for(GameObject *gameObject : gameObjects)
+        Render((float)(accumulator / tickDuration));
+
+        statsTime += frameTime.count();
+        if(statsTime >= RenderStatsInterval)
         {
-            gameObject->Update();
-            if(gameObject->GetObject() != GameObject::PLAYER || mainCamera->GetType() != Camera::FIRST_PERSON)
+            if(showRenderStats)
             {
-                if(gameObject->GetObject() != GameObject::PLAYER || state != GameState::OVER)
-                    gameObject->Draw();
+                const RenderState::Stats &stats = renderState.GetStats();
+                std::cout << "GAME::RENDER::STATS draws " << stats.drawCalls << ", programs " << stats.programChanges
+                          << ", vertex arrays " << stats.vertexArrayChanges << ", textures " << stats.textureChanges
+                          << ", uniforms " << stats.uniformChanges << std::endl;
+                // Only counted in debug builds, instance lists settle after the first frames and drawing should not allocate
+                std::cout << "GAME::RENDER::ALLOCATIONS " << drawAllocations << " in the last " << statsTime << " s" << std::endl;
             }
+
+            statsTime = 0.0;
+            drawAllocations = 0;
         }
 
-        // minimap
-        glViewport(0, display.h - (display.h * 0.2), display.w * 0.2, display.h * 0.2);
-        projection = glm::ortho(-20.0, 20.0, -20.0, 20.0, 0.0, 50.0);
-        view = camera->GetViewMatrix();
-        shader->SetUniform("projection", projection);
-        shader->SetUniform("view", view);
+        SDL_GL_SwapWindow(window);
+    }
+}
+
+void Game::Simulate(int ticks)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    int tick = 0;
+    for(; tick < ticks && state == GameState::RUNNING; ++tick)
+    {
+        SimulateInput();
+        Tick();
+    }
 
-        for(GameObject *gameObject : gameObjects)
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    const char *stateName = state == GameState::RUNNING ? "RUNNING" : (state == GameState::OVER ? "OVER" : "WIN");
+
+    std::cout << "Simulated " << tick << " ticks in " << elapsed.count() << "s ("
+              << (elapsed.count() > 0.0 ? tick / elapsed.count() : 0.0) << " ticks/s), state: "
+              << stateName << ", enemies left: " << enemies.size() << std::endl;
+}
+
+void Game::Tick()
+{
+    if(state == GameState::RUNNING)
+    {
+        UpdateEnemies();
+        Update();
+    }
+
+    gameObjects.Update((float)tickDuration);
+
+    DestroySunkObjects();
+}
+
+void Game::Render(float alpha)
+{
+    if(state == GameState::RUNNING)
+    {
+        UpdateCamera(alpha);
+    }
+
+    BakeLevelMesh();
+    unsigned long long allocations = AllocationCounter::GetCount();
+
+    // Baking and the texture array bind behind the state cache, so it starts the frame knowing nothing
+    blockTextures.Bind();
+    renderState.Reset();
+    renderState.ResetStats();
+
+    glClearColor(0.0f, 0.5f, 0.75f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    glViewport(0, 0, display.w, display.h);
+    // Transformation matrices
+    float extent = (float)std::max(levelWidth, levelHeight);
+    glm::mat4 projection = glm::perspective(45.0f, (float)display.w / display.h, 0.1f, extent * 5.0f);
+    glm::mat4 view = mainCamera->GetViewMatrix();
+    shader->SetUniform(uniforms.projection, projection);
+    shader->SetUniform(uniforms.view, view);
+    shader->SetUniform(uniforms.viewPosition, camera->GetEye());
+
+    gameObjects.Draw(alpha);
+
+    for(Model *model : models)
+    {
+        model->UploadInstances();
+    }
+
+    levelMesh.Queue(renderQueue, shader, mainCamera->GetEye());
+
+    bool drawPlayer = mainCamera->GetType() != Camera::FIRST_PERSON && state != GameState::OVER;
+    for(Model *model : models)
+    {
+        if(model != models[GameObject::PLAYER] || drawPlayer)
         {
-            gameObject->Draw();
+            model->QueueInstances(renderQueue, shader);
         }
+    }
 
-        SDL_GL_SwapWindow(window);
+    renderQueue.Flush(renderState);
+
+    // minimap
+    glViewport(0, display.h - (display.h * 0.2), display.w * 0.2, display.h * 0.2);
+    projection = glm::ortho((float)-levelWidth, (float)levelWidth, (float)-levelHeight, (float)levelHeight, 0.0f, extent * 2.5f);
+    view = camera->GetViewMatrix();
+    shader->SetUniform(uniforms.projection, projection);
+    shader->SetUniform(uniforms.view, view);
+
+    levelMesh.Queue(renderQueue, shader, camera->GetEye());
+
+    for(Model *model : models)
+    {
+        model->QueueInstances(renderQueue, shader);
+    }
+
+    renderQueue.Flush(renderState);
+
+    for(Model *model : models)
+    {
+        model->ClearInstances();
+    }
+
+    drawAllocations += AllocationCounter::GetCount() - allocations;
+}
+
+void Game::BakeLevelMesh()
+{
+    for(int chunk : levelMesh.GetDirtyChunks())
+    {
+        int startX;
+        int startZ;
+        int endX;
+        int endZ;
+        levelMesh.GetChunkTiles(chunk, &startX, &startZ, &endX, &endZ);
+
+        // Static blocks of the chunk and its one tile border, by level, row and column
+        const int size = LevelMesh::BakeGridSize;
+        bakeObjects.assign(2 * size * size, nullptr);
+        for(int level = Level::GROUND; level <= Level::ABOVE; ++level)
+        {
+            for(int z = startZ - 1; z <= endZ; ++z)
+            {
+                for(int x = startX - 1; x <= endX; ++x)
+                {
+                    GameObject *gameObject = GetGameObjectFromGrid((Level)level, x, z);
+                    if(gameObject != nullptr && gameObject->IsStatic())
+                    {
+                        bakeObjects[(level * size + z - startZ + 1) * size + x - startX + 1] = gameObject;
+                    }
+                }
+            }
+        }
+
+        levelMesh.Bake(chunk, bakeObjects, shader);
+    }
+
+    levelMesh.ClearDirtyChunks();
+}
+
+void Game::PrintMemoryReport(std::ostream &stream)
+{
+    size_t cpuBytes = levelMesh.GetCpuBytes();
+    size_t gpuBytes = levelMesh.GetGpuBytes();
+    stream << "Meshes:" << std::endl;
+    for(Model *model : models)
+    {
+        stream << "  " << model->GetName() << " CPU " << model->GetCpuBytes() << " bytes, GPU " << model->GetGpuBytes() << " bytes" << std::endl;
+        cpuBytes += model->GetCpuBytes();
+        gpuBytes += model->GetGpuBytes();
     }
+    stream << "  level mesh CPU " << levelMesh.GetCpuBytes() << " bytes, GPU " << levelMesh.GetGpuBytes() << " bytes" << std::endl;
+    stream << "  total CPU " << cpuBytes << " bytes, GPU " << gpuBytes << " bytes" << std::endl;
+}
+
+void Game::LoadUniforms()
+{
+    uniforms.projection = shader->GetUniformLocation("projection");
+    uniforms.view = shader->GetUniformLocation("view");
+    uniforms.viewPosition = shader->GetUniformLocation("viewPosition");
+    shader->SetUniform("blockTextures", (int)TextureArray::TextureUnit);
+
+    // The light never changes, so it is set once instead of every frame
+    shader->SetUniform("lights[0].position", glm::vec3(levelWidth, std::max(levelWidth, levelHeight), levelHeight));
+    shader->SetUniform("lights[0].ambient", glm::vec3(0.3f, 0.3f, 0.3f));
+    shader->SetUniform("lights[0].diffuse", glm::vec3(1.0f, 1.0f, 1.0f));
+    shader->SetUniform("lights[0].specular", glm::vec3(1.0f, 1.0f, 1.0f));
+    shader->SetUniform("lights[0].constant", 1.0f);
+    shader->SetUniform("lights[0].linear", 0.009f);
+    shader->SetUniform("lights[0].quadratic", 0.0032f);
 }
 
 void Game::LoadModels()
 {
-    models.push_back(new Model("grass_block.obj"));
-    models.push_back(new Model("hole_block.obj"));
-    models.push_back(new Model("hole_one_block.obj"));
-    models.push_back(new Model("hole_two_block.obj"));
-    models.push_back(new Model("hole_two_l_block.obj"));
-    models.push_back(new Model("hole_three_block.obj"));
-    models.push_back(new Model("hole_four_block.obj"));
-    models.push_back(new Model("crack_block.obj"));
-    models.push_back(new Model("crack_one_block.obj"));
-    models.push_back(new Model("crack_two_block.obj"));
-    models.push_back(new Model("crack_two_l_block.obj"));
-    models.push_back(new Model("crack_three_block.obj"));
-    models.push_back(new Model("crack_four_block.obj"));
+    // Every block variant samples the one texture array, so any mix of blocks can share a draw. Blocks keep
+    // their vertices after upload because the level mesh bakes from them
+    models.push_back(new Model("grass_block.obj", &blockTextures, true));
+    models.push_back(new Model("hole_block.obj", &blockTextures, true));
+    models.push_back(new Model("hole_one_block.obj", &blockTextures, true));
+    models.push_back(new Model("hole_two_block.obj", &blockTextures, true));
+    models.push_back(new Model("hole_two_l_block.obj", &blockTextures, true));
+    models.push_back(new Model("hole_three_block.obj", &blockTextures, true));
+    models.push_back(new Model("hole_four_block.obj", &blockTextures, true));
+    models.push_back(new Model("crack_block.obj", &blockTextures, true));
+    models.push_back(new Model("crack_one_block.obj", &blockTextures, true));
+    models.push_back(new Model("crack_two_block.obj", &blockTextures, true));
+    models.push_back(new Model("crack_two_l_block.obj", &blockTextures, true));
+    models.push_back(new Model("crack_three_block.obj", &blockTextures, true));
+    models.push_back(new Model("crack_four_block.obj", &blockTextures, true));
     models.push_back(new Model("player.obj"));
     models.push_back(new Model("enemy.obj"));
+
+    // Models load on worker threads, their GL objects and the block texture array are created here
+    AssetLoader().Load(models, &blockTextures);
+
+    // The cooker printed the stats of cooked models when it optimized them
+    for(Model *model : models)
+    {
+        if(model->IsCooked())
+        {
+            continue;
+        }
+
+        const Model::OptimizeStats &stats = model->GetOptimizeStats();
+        std::cout << "GAME::LOAD::OPTIMIZE " << model->GetName() << " meshes " << stats.meshesBefore << " -> " << stats.meshesAfter
+                  << ", vertices " << stats.verticesBefore << " -> " << stats.verticesAfter
+                  << ", ACMR " << stats.acmrBefore << " -> " << stats.acmrAfter << std::endl;
+    }
+
+    for(Model *model : models)
+    {
+        model->LoadUniforms(shader);
+    }
 }
 
 void Game::LoadLevel()
 {
-    int width;
-    int height;
     FREE_IMAGE_FORMAT format;
     FIBITMAP *image;
 
-    format = FreeImage_GetFileType(LevelGroundPath.c_str());
+    // Reloading drops the previous level in one go, handles into it go stale
+    gameObjects.Clear();
+    enemies.clear();
+    sinkingObjects.clear();
+    playerHandle = GameObjectPool::NullHandle;
+    state = GameState::RUNNING;
+    mainCamera = camera;
+    delete fpsCamera;
+    delete thirdCamera;
+    fpsCamera = nullptr;
+    thirdCamera = nullptr;
 
-    image = FreeImage_Load(format, LevelGroundPath.c_str());
-    width = FreeImage_GetWidth(image);
-    height = FreeImage_GetHeight(image);
+    format = FreeImage_GetFileType(levelGroundPath.c_str());
 
-    if(width != LevelSize || height != LevelSize)
+    // The ground image decides the level size, the above image has to match it
+    image = FreeImage_Load(format, levelGroundPath.c_str());
+    if(image == nullptr)
     {
-        std::cerr << "GAME::LOAD_LEVEL::GROUND_WRONG_SIZE";
+        std::cerr << "GAME::LOAD_LEVEL::GROUND_NOT_FOUND " << levelGroundPath << std::endl;
         return;
     }
 
+    levelWidth = FreeImage_GetWidth(image);
+    levelHeight = FreeImage_GetHeight(image);
+
+    levelGrid[Level::GROUND].assign(levelWidth * levelHeight, GameObjectPool::NullHandle);
+    levelGrid[Level::ABOVE].assign(levelWidth * levelHeight, GameObjectPool::NullHandle);
+    // Each layer holds at most one object per tile, the player and enemies take tiles of the above layer, so
+    // both layers together bound every object the level creates
+    gameObjects.Reserve(2 * levelWidth * levelHeight);
+    tiles.Resize(levelWidth, levelHeight);
+    levelMesh.Resize(levelWidth, levelHeight);
+    dirtyTiles.assign(levelWidth * levelHeight, false);
+    dirtyTileList.clear();
+    dirtyTileList.reserve(levelWidth * levelHeight);
+
     image = FreeImage_ConvertTo24Bits(image);
     MapImageToLevel(image, Level::GROUND);
 
-    image = FreeImage_Load(format, LevelAbovePath.c_str());
-    width = FreeImage_GetWidth(image);
-    height = FreeImage_GetHeight(image);
+    image = FreeImage_Load(format, levelAbovePath.c_str());
+    if(image == nullptr)
+    {
+        std::cerr << "GAME::LOAD_LEVEL::ABOVE_NOT_FOUND " << levelAbovePath << std::endl;
+        return;
+    }
 
-    if(width != LevelSize || height != LevelSize)
+    if((int)FreeImage_GetWidth(image) != levelWidth || (int)FreeImage_GetHeight(image) != levelHeight)
     {
         std::cerr << "GAME::LOAD_LEVEL::ABOVE_WRONG_SIZE";
         return;
@@ -171,6 +428,14 @@ void Game::LoadLevel()
 
     image = FreeImage_ConvertTo24Bits(image);
     MapImageToLevel(image, Level::ABOVE);
+
+    for(int z = 0; z < levelHeight; ++z)
+    {
+        for(int x = 0; x < levelWidth; ++x)
+        {
+            MarkTileDirty(x, z);
+        }
+    }
     AdjustBlocksTexture();
     FloodFill();
     RemoveStrandedCracks();
@@ -178,11 +443,11 @@ void Game::LoadLevel()
 
 void Game::MapImageToLevel(FIBITMAP *image, Level level)
 {
-    for(int height = LevelSize - 1, i = 0; height >= 0; --height, ++i)
+    for(int height = levelHeight - 1, i = 0; height >= 0; --height, ++i)
     {
-        for(int width = 0; width < LevelSize; ++width)
+        for(int width = 0; width < levelWidth; ++width)
         {
-            GameObject *gameObject = nullptr;
+            GameObjectHandle handle = GameObjectPool::NullHandle;
             RGBQUAD color;
 
             FreeImage_GetPixelColor(image, width, height, &color);
@@ -194,42 +459,42 @@ void Game::MapImageToLevel(FIBITMAP *image, Level level)
             switch(hexColor)
             {
             case 0x00ff00: // Green: normal terrain
-                gameObject = new GameObject(shader, models[GameObject::GRASS], glm::vec3(width * 2.0, level * 2.0, i * 2.0), GameObject::GRASS, width, i);
+                handle = gameObjects.Create(models[GameObject::GRASS], glm::vec3(width * 2.0, level * 2.0, i * 2.0), GameObject::GRASS, width, i);
+                gameObjects.Get(handle)->SetStatic(true);
                 break;
             case 0x542100: // Dark Brown: hole
                 if(ExistsFloorAt(width, i))
                 {
-                    GetGameObjectFromGrid(Level::GROUND, width, i)->SetModel(models[GameObject::HOLE], GameObject::HOLE);
+                    SetBlockObject(GetGameObjectFromGrid(Level::GROUND, width, i), GameObject::HOLE);
                 }
                 break;
             case 0x7A5C46: // Light Brown: crack
                 if(ExistsFloorAt(width, i))
                 {
-                    GetGameObjectFromGrid(Level::GROUND, width, i)->SetModel(models[GameObject::CRACK], GameObject::CRACK);
+                    SetBlockObject(GetGameObjectFromGrid(Level::GROUND, width, i), GameObject::CRACK);
                 }
                 break;
             case 0xff0000: // Red: enemy
                 if(ExistsFloorAt(width, i))
                 {
-                    gameObject = new GameObject(shader, models[GameObject::ENEMY], glm::vec3(width * 2.0, 2.3, i * 2.0), GameObject::ENEMY, width, i);
-                    enemies.push_back(gameObject);
+                    handle = gameObjects.Create(models[GameObject::ENEMY], glm::vec3(width * 2.0, 2.3, i * 2.0), GameObject::ENEMY, width, i);
+                    enemies.push_back(handle);
                 }
                 break;
             case 0xffff00: // Yellow: player
                 if(ExistsFloorAt(width, i))
                 {
-                    gameObject = new GameObject(shader, models[GameObject::PLAYER], glm::vec3(width * 2.0, 2.3, i * 2.0), GameObject::PLAYER, width, i);
+                    handle = gameObjects.Create(models[GameObject::PLAYER], glm::vec3(width * 2.0, 2.3, i * 2.0), GameObject::PLAYER, width, i);
                     fpsCamera = new Camera(glm::vec3(width * 2.0, 3.0, i * 2.0), glm::vec3(0.0, 0.0, 1.0), Camera::FIRST_PERSON);
                     thirdCamera = new Camera(glm::vec3(width * 2.0, 5.0, (i * 2.0) - 5.0), glm::vec3(width * 2.0, 2.0, i * 2.0), Camera::THIRD_PERSON);
-                    player = gameObject;
+                    playerHandle = handle;
                 }
                 break;
             }
 
-            if(gameObject != nullptr)
+            if(handle != GameObjectPool::NullHandle)
             {
-                gameObjects.push_back(gameObject);
-                levelGrid[level][i][width] = gameObject;
+                SetGridObject(level, width, i, gameObjects.Get(handle));
             }
         }
     }
@@ -237,363 +502,406 @@ void Game::MapImageToLevel(FIBITMAP *image, Level level)
 
 bool Game::ExistsFloorAt(int x, int y)
 {
-    return GetGameObjectFromGrid(Level::GROUND, x, y) != nullptr;
+    return tiles.Get(Level::GROUND, x, y) != GameObject::OBJECT_NULL;
 }
 
 GameObject * Game::GetGameObjectFromGrid(Level level, int x, int z)
 {
-    if(x < 0 || x >= LevelSize || z < 0 || z >= LevelSize)
+    if(!tiles.IsInside(x, z))
     {
         return nullptr;
     }
     else
     {
-        return levelGrid[level][z][x];
+        return gameObjects.Get(levelGrid[level][z * levelWidth + x]);
     }
 }
 
-void Game::AdjustBlocksTexture()
+void Game::SetGridObject(Level level, int x, int z, GameObject *gameObject)
+{
+    levelGrid[level][z * levelWidth + x] = gameObjects.GetHandle(gameObject);
+    tiles.Set(level, x, z, gameObject != nullptr ? gameObject->GetObject() : GameObject::OBJECT_NULL);
+}
+
+GameObject * Game::GetPlayer()
+{
+    return gameObjects.Get(playerHandle);
+}
+
+void Game::SetBlockObject(GameObject *block, GameObject::Object object)
+{
+    block->SetModel(models[object], object);
+    tiles.Set(Level::GROUND, block->GetPositionX(), block->GetPositionZ(), object);
+    levelMesh.MarkDirty(block->GetPositionX(), block->GetPositionZ());
+}
+
+void Game::LoadTileShapes()
 {
-    for(int x = 0; x < LevelSize; ++x)
+    for(int index = 0; index < TileShapeCount; ++index)
     {
-        for(int z = 0; z < LevelSize; ++z)
+        Neighbour top = (Neighbour)(index % 3);
+        Neighbour bottom = (Neighbour)(index / 3 % 3);
+        Neighbour right = (Neighbour)(index / 9 % 3);
+        Neighbour left = (Neighbour)(index / 27 % 3);
+
+        // Sides off the map or without a block count as open when joining pieces
+        bool openTop = top != Neighbour::SOLID;
+        bool openBottom = bottom != Neighbour::SOLID;
+        bool openRight = right != Neighbour::SOLID;
+        bool openLeft = left != Neighbour::SOLID;
+
+        int holeCount = (top == Neighbour::OPEN) + (bottom == Neighbour::OPEN) + (right == Neighbour::OPEN) + (left == Neighbour::OPEN);
+        TileShape shape = {TileVariant::TILE_SINGLE, 0.0f};
+
+        if(holeCount == 1)
         {
-            GameObject *block = GetGameObjectFromGrid(Level::GROUND, x, z);
-            if(block != nullptr && (block->GetObject() == GameObject::HOLE || block->GetObject() == GameObject::CRACK))
+            // A single opening faces its neighbour, unless the opposite side is empty, then the piece runs straight through
+            Neighbour opposite;
+            if(left == Neighbour::OPEN)
+            {
+                shape.degrees = 270.0f;
+                opposite = right;
+            }
+            else if(top == Neighbour::OPEN)
+            {
+                shape.degrees = 180.0f;
+                opposite = bottom;
+            }
+            else if(right == Neighbour::OPEN)
+            {
+                shape.degrees = 90.0f;
+                opposite = left;
+            }
+            else
+            {
+                opposite = top;
+            }
+
+            if(opposite != Neighbour::EMPTY)
+            {
+                shape.variant = TileVariant::TILE_ONE;
+            }
+            else
+            {
+                holeCount = 2;
+            }
+        }
+
+        if(holeCount == 2)
+        {
+            if(openRight && openLeft)
+            {
+                shape.variant = TileVariant::TILE_TWO;
+                shape.degrees = 90.0f;
+            }
+            else if(openTop && openBottom)
+            {
+                shape.variant = TileVariant::TILE_TWO;
+            }
+            else
             {
-                GameObject *top = GetGameObjectFromGrid(Level::GROUND, x, z - 1);
-                GameObject *bottom = GetGameObjectFromGrid(Level::GROUND, x, z + 1);
-                GameObject *right = GetGameObjectFromGrid(Level::GROUND, x + 1, z);
-                GameObject *left = GetGameObjectFromGrid(Level::GROUND, x - 1, z);
-
-                int neighbourCount = 0;
-                std::vector<GameObject*> neighbours = {top, bottom, right, left};
-                for(GameObject* neighbour : neighbours)
+                shape.variant = TileVariant::TILE_TWO_L;
+                if(openBottom && openLeft)
                 {
-                    if(neighbour != nullptr && (neighbour->GetObject() == GameObject::HOLE || neighbour->GetObject() == GameObject::CRACK))
-                    {
-                        ++neighbourCount;
-                    }
+                    shape.degrees = 270.0f;
                 }
-
-                GameObject::Object object = GameObject::OBJECT_NULL;
-                float degrees = 0.0;
-                switch(neighbourCount)
+                else if(openLeft && openTop)
                 {
-                case 0:
-                    if(block->GetObject() == GameObject::HOLE)
-                    {
-                        object = GameObject::HOLE;
-                    }
-                    else
-                    {
-                        object = GameObject::CRACK;
-                    }
-                    break;
-                case 1:
-                    if(block->GetObject() == GameObject::HOLE)
-                    {
-                        object = GameObject::HOLE_ONE;
-                    }
-                    else
-                    {
-                        object = GameObject::CRACK_ONE;
-                    }
-                    if(left != nullptr && (left->GetObject() == GameObject::HOLE || left->GetObject() == GameObject::CRACK))
-                    {
-                        degrees = 270.0;
-                        if(right != nullptr)
-                        {
-                            break;
-                        }
-                    }
-                    else if(top != nullptr && (top->GetObject() == GameObject::HOLE || top->GetObject() == GameObject::CRACK))
-                    {
-                        degrees = 180.0;
-                        if(bottom != nullptr)
-                        {
-                            break;
-                        }
-                    }
-                    else if(right != nullptr && (right->GetObject() == GameObject::HOLE || right->GetObject() == GameObject::CRACK))
-                    {
-                        degrees = 90.0;
-                        if(left != nullptr)
-                        {
-                            break;
-                        }
-                    }
-                    else
-                    {
-                        if(top != nullptr)
-                        {
-                            break;
-                        }
-                    }
-                case 2:
-                    if(block->GetObject() == GameObject::HOLE)
-                    {
-                        object = GameObject::HOLE_TWO;
-                    }
-                    else
-                    {
-                        object = GameObject::CRACK_TWO;
-                    }
-                    if((right == nullptr || right->GetObject() == GameObject::HOLE || right->GetObject() == GameObject::CRACK) &&
-                       (left == nullptr || left->GetObject() == GameObject::HOLE || left->GetObject() == GameObject::CRACK))
-                    {
-                        degrees = 90.0;
-                        break;
-                    }
-                    else if((top == nullptr || top->GetObject() == GameObject::HOLE || top->GetObject() == GameObject::CRACK) &&
-                            (bottom == nullptr || bottom->GetObject() == GameObject::HOLE || bottom->GetObject() == GameObject::CRACK))
-                    {
-                        break;
-                    }
-                    if(block->GetObject() == GameObject::HOLE)
-                    {
-                        object = GameObject::HOLE_TWO_L;
-                    }
-                    else
-                    {
-                        object = GameObject::CRACK_TWO_L;
-                    }
-                    if((bottom == nullptr || bottom->GetObject() == GameObject::HOLE || bottom->GetObject() == GameObject::CRACK) &&
-                        (left == nullptr || left->GetObject() == GameObject::HOLE || left->GetObject() == GameObject::CRACK))
-                    {
-                        degrees = 270.0;
-                    }
-                    else if((left == nullptr || left->GetObject() == GameObject::HOLE || left->GetObject() == GameObject::CRACK) &&
-                        (top == nullptr || top->GetObject() == GameObject::HOLE || top->GetObject() == GameObject::CRACK))
-                    {
-                        degrees = 180.0;
-                    }
-                    else if((right == nullptr || right->GetObject() == GameObject::HOLE || right->GetObject() == GameObject::CRACK) &&
-                        (top == nullptr || top->GetObject() == GameObject::HOLE || top->GetObject() == GameObject::CRACK))
-                    {
-                        degrees = 90.0;
-                    }
-                    break;
-                case 3:
-                    if(block->GetObject() == GameObject::HOLE)
-                    {
-                        object = GameObject::HOLE_THREE;
-                    }
-                    else
-                    {
-                        object = GameObject::CRACK_THREE;
-                    }
-                    if(left != nullptr && left->GetObject() != GameObject::HOLE && left->GetObject() != GameObject::CRACK)
-                    {
-                        degrees = 90.0;
-                        if(left != nullptr)
-                        {
-                            break;
-                        }
-                    }
-                    else if(bottom != nullptr && bottom->GetObject() != GameObject::HOLE && bottom->GetObject() != GameObject::CRACK)
-                    {
-                        degrees = 180.0;
-                        if(bottom != nullptr)
-                        {
-                            break;
-                        }
-                    }
-                    else if(right != nullptr && right->GetObject() != GameObject::HOLE && right->GetObject() != GameObject::CRACK)
-                    {
-                        degrees = 270.0;
-                        if(right != nullptr)
-                        {
-                            break;
-                        }
-                    }
-                case 4:
-                    if(block->GetObject() == GameObject::HOLE)
-                    {
-                        object = GameObject::HOLE_FOUR;
-                    }
-                    else
-                    {
-                        object = GameObject::CRACK_FOUR;
-                    }
-                    break;
+                    shape.degrees = 180.0f;
                 }
-
-                if(object != GameObject::OBJECT_NULL)
+                else if(openRight && openTop)
                 {
-                    block->SetModel(models[object], block->GetObject());
-                    block->Rotate(degrees);
+                    shape.degrees = 90.0f;
                 }
             }
         }
+        else if(holeCount == 3)
+        {
+            shape.variant = TileVariant::TILE_THREE;
+            if(left == Neighbour::SOLID)
+            {
+                shape.degrees = 90.0f;
+            }
+            else if(bottom == Neighbour::SOLID)
+            {
+                shape.degrees = 180.0f;
+            }
+            else if(right == Neighbour::SOLID)
+            {
+                shape.degrees = 270.0f;
+            }
+            else
+            {
+                shape.variant = TileVariant::TILE_FOUR;
+            }
+        }
+        else if(holeCount == 4)
+        {
+            shape.variant = TileVariant::TILE_FOUR;
+        }
+
+        tileShapes[index] = shape;
+    }
+}
+
+Game::Neighbour Game::GetNeighbour(int x, int z)
+{
+    GameObject::Object object = tiles.Get(Level::GROUND, x, z);
+    if(object == GameObject::OBJECT_NULL)
+    {
+        return Neighbour::EMPTY;
+    }
+    else if(object == GameObject::HOLE || object == GameObject::CRACK)
+    {
+        return Neighbour::OPEN;
+    }
+    else
+    {
+        return Neighbour::SOLID;
+    }
+}
+
+void Game::MarkTileDirty(int x, int z)
+{
+    static const int offsets[5][2] = {{0, 0}, {0, 1}, {0, -1}, {1, 0}, {-1, 0}};
+
+    // A tile's shape depends on its four neighbours, so they need adjusting as well
+    for(const int *offset : offsets)
+    {
+        int nx = x + offset[0];
+        int nz = z + offset[1];
+        if(tiles.IsInside(nx, nz) && !dirtyTiles[nz * levelWidth + nx])
+        {
+            dirtyTiles[nz * levelWidth + nx] = true;
+            dirtyTileList.push_back(nz * levelWidth + nx);
+        }
+    }
+}
+
+void Game::AdjustBlocksTexture()
+{
+    for(int tile : dirtyTileList)
+    {
+        dirtyTiles[tile] = false;
+
+        int x = tile % levelWidth;
+        int z = tile / levelWidth;
+
+        if(tiles.IsOpen(Level::GROUND, x, z))
+        {
+            GameObject *block = GetGameObjectFromGrid(Level::GROUND, x, z);
+            int index = GetNeighbour(x, z - 1)
+                        + GetNeighbour(x, z + 1) * 3
+                        + GetNeighbour(x + 1, z) * 9
+                        + GetNeighbour(x - 1, z) * 27;
+            const TileShape &shape = tileShapes[index];
+
+            block->SetModel(models[block->GetObject() + shape.variant], block->GetObject());
+            block->Rotate(shape.degrees);
+            levelMesh.MarkDirty(x, z);
+        }
     }
+
+    dirtyTileList.clear();
 }
 
 void Game::FloodFill()
 {
-    std::vector<GameObject*> grassBlocks;
+    std::vector<int> labels(levelWidth * levelHeight, -1);
+    std::vector<GameObject*> blocks;
+    std::vector<size_t> islandStarts;
 
-    for(int x = 0; x < LevelSize; ++x)
+    // Label every island of connected grass, blocks of one island are stored contiguously
+    for(int x = 0; x < levelWidth; ++x)
     {
-        for(int y = 0; y < LevelSize; ++y)
+        for(int z = 0; z < levelHeight; ++z)
         {
-            GameObject *block = GetGameObjectFromGrid(Level::GROUND, x, y);
-            if(block != nullptr && block->GetObject() == GameObject::GRASS)
+            if(tiles.Get(Level::GROUND, x, z) == GameObject::GRASS && labels[z * levelWidth + x] == -1)
             {
-                grassBlocks.push_back(block);
+                islandStarts.push_back(blocks.size());
+                Flood(GetGameObjectFromGrid(Level::GROUND, x, z), islandStarts.size() - 1, &labels, &blocks);
             }
         }
     }
 
-    if(grassBlocks.empty())
+    if(islandStarts.size() < 2)
     {
         return;
     }
+    islandStarts.push_back(blocks.size());
 
-    std::vector<GameObject*> firstArea;
-    Flood(grassBlocks.front(), &grassBlocks, &firstArea);
-
-    if(!grassBlocks.empty())
+    size_t largestIsland = 0;
+    for(size_t i = 1; i + 1 < islandStarts.size(); ++i)
     {
-        std::vector<GameObject*> secondArea;
-        Flood(grassBlocks.front(), &grassBlocks, &secondArea);
-
-        std::vector<GameObject*> *deleteArea;
-        if(firstArea.size() <= secondArea.size())
+        if(islandStarts[i + 1] - islandStarts[i] >= islandStarts[largestIsland + 1] - islandStarts[largestIsland])
         {
-            deleteArea = &firstArea;
+            largestIsland = i;
         }
-        else
+    }
+
+    size_t keptIsland = largestIsland;
+    if(islandRule == IslandRule::KEEP_PLAYER_ISLAND)
+    {
+        int playerIsland = GetPlayerIsland(labels, islandStarts);
+        if(playerIsland != -1)
         {
-            deleteArea = &secondArea;
+            keptIsland = (size_t)playerIsland;
         }
+    }
 
-        while(!deleteArea->empty())
+    for(size_t i = 0; i + 1 < islandStarts.size(); ++i)
+    {
+        if(i != keptIsland)
         {
-            GameObject *block = deleteArea->front();
+            for(size_t j = islandStarts[i]; j < islandStarts[i + 1]; ++j)
+            {
+                SinkBlock(blocks[j]);
+            }
+        }
+    }
+}
 
-            block->SetState(GameObject::MOVING);
-            block->SetVelocity(glm::vec3(0.0, -0.1, 0.0));
+void Game::Flood(GameObject* block, int label, std::vector<int> *labels, std::vector<GameObject*> *blocks)
+{
+    static const int offsets[4][2] = {{0, 1}, {0, -1}, {1, 0}, {-1, 0}};
 
-            int x = block->GetPositionX();
-            int z = block->GetPositionZ();
+    (*labels)[block->GetPositionZ() * levelWidth + block->GetPositionX()] = label;
+    size_t start = blocks->size();
+    blocks->push_back(block);
 
-            levelGrid[Level::GROUND][z][x] = nullptr;
+    // Breadth-first search, the island's own blocks are the queue of blocks still to expand
+    for(size_t i = start; i < blocks->size(); ++i)
+    {
+        int x = (*blocks)[i]->GetPositionX();
+        int z = (*blocks)[i]->GetPositionZ();
 
-            GameObject *above = GetGameObjectFromGrid(Level::ABOVE, x, z);
-            if(above != nullptr && above->GetObject() == GameObject::GRASS)
+        for(const int *offset : offsets)
+        {
+            int nx = x + offset[0];
+            int nz = z + offset[1];
+            if(tiles.Get(Level::GROUND, nx, nz) == GameObject::GRASS && (*labels)[nz * levelWidth + nx] == -1)
             {
-                above->SetState(GameObject::MOVING);
-                above->SetVelocity(glm::vec3(0.0, -0.1, 0.0));
-
-                levelGrid[Level::ABOVE][z][x] = nullptr;
+                (*labels)[nz * levelWidth + nx] = label;
+                blocks->push_back(GetGameObjectFromGrid(Level::GROUND, nx, nz));
             }
-
-            deleteArea->erase(deleteArea->begin());
         }
     }
 }
 
-void Game::Flood(GameObject* block, std::vector<GameObject*> *grassBlocks, std::vector<GameObject*> *area)
+int Game::GetPlayerIsland(const std::vector<int> &labels, const std::vector<size_t> &islandStarts)
 {
-    if(block == nullptr)
+    GameObject *player = GetPlayer();
+    if(player == nullptr)
     {
-        return;
+        return -1;
     }
 
-    // if block is not in the list, means the block was already visited or the block is not grass
-    if(std::find(grassBlocks->begin(), grassBlocks->end(), block) == grassBlocks->end())
+    int x = player->GetPositionX();
+    int z = player->GetPositionZ();
+    if(!tiles.IsInside(x, z))
     {
-        return;
+        return -1;
     }
 
-    int x = block->GetPositionX();
-    int z = block->GetPositionZ();
-
-    // block belongs to area
-    area->push_back(block);
-
-    // remove block from list
-    grassBlocks->erase(std::remove(grassBlocks->begin(), grassBlocks->end(), block), grassBlocks->end());
-
-    if(grassBlocks->empty())
+    if(labels[z * levelWidth + x] != -1)
     {
-        return;
+        return labels[z * levelWidth + x];
     }
 
-    Flood(GetGameObjectFromGrid(Level::GROUND, x, z + 1), grassBlocks, area);
-    Flood(GetGameObjectFromGrid(Level::GROUND, x, z - 1), grassBlocks, area);
-    Flood(GetGameObjectFromGrid(Level::GROUND, x + 1, z), grassBlocks, area);
-    Flood(GetGameObjectFromGrid(Level::GROUND, x - 1, z), grassBlocks, area);
-}
-
-void Game::RemoveStrandedCracks()
-{
-    std::vector<GameObject*> deleteArea;
-    
-    for(int x = 0; x < LevelSize; ++x)
+    // The player stands on a hole or crack, it belongs to the biggest island it touches
+    static const int offsets[4][2] = {{0, 1}, {0, -1}, {1, 0}, {-1, 0}};
+    int playerIsland = -1;
+    for(const int *offset : offsets)
     {
-        for(int z = 0; z < LevelSize; ++z)
+        int nx = x + offset[0];
+        int nz = z + offset[1];
+        if(!tiles.IsInside(nx, nz))
         {
-            GameObject *block = GetGameObjectFromGrid(Level::GROUND, x, z);
-
-            if(block != nullptr && (block->GetObject() == GameObject::CRACK || block->GetObject() == GameObject::HOLE))
-            {
-                GameObject *top = GetGameObjectFromGrid(Level::GROUND, x, z - 1);
-                GameObject *bottom = GetGameObjectFromGrid(Level::GROUND, x, z + 1);
-                GameObject *right = GetGameObjectFromGrid(Level::GROUND, x + 1, z);
-                GameObject *left = GetGameObjectFromGrid(Level::GROUND, x - 1, z);
-                GameObject *topRight = GetGameObjectFromGrid(Level::GROUND, x + 1, z - 1);
-                GameObject *topLeft = GetGameObjectFromGrid(Level::GROUND, x - 1, z - 1);
-                GameObject *bottomRight = GetGameObjectFromGrid(Level::GROUND, x + 1, z + 1);
-                GameObject *bottomLeft = GetGameObjectFromGrid(Level::GROUND, x - 1, z + 1);
-
-                std::vector<GameObject*> neighbours = {top, bottom, right, left, topRight, topLeft, bottomRight, bottomLeft};
-                bool grassNearby = false;
-                for(GameObject *neighbour : neighbours)
-                {
-                    if(neighbour != nullptr && neighbour->GetObject() == GameObject::GRASS)
-                    {
-                        grassNearby = true;
-                        break;
-                    }
-                }
+            continue;
+        }
 
-                if(!grassNearby)
-                {
-                    deleteArea.push_back(block);
-                }
-            }
+        int label = labels[nz * levelWidth + nx];
+        if(label != -1 && (playerIsland == -1 ||
+           islandStarts[label + 1] - islandStarts[label] > islandStarts[playerIsland + 1] - islandStarts[playerIsland]))
+        {
+            playerIsland = label;
         }
     }
 
-    while(!deleteArea.empty())
-    {
-        GameObject *block = deleteArea.front();
+    return playerIsland;
+}
 
-        block->SetState(GameObject::MOVING);
-        block->SetVelocity(glm::vec3(0.0, -0.1, 0.0));
+void Game::SinkBlock(GameObject *block)
+{
+    block->SetState(GameObject::MOVING);
+    block->SetVelocity(glm::vec3(0.0, -FallSpeed, 0.0));
+    block->SetStatic(false);
+    sinkingObjects.push_back(gameObjects.GetHandle(block));
 
-        int x = block->GetPositionX();
-        int z = block->GetPositionZ();
+    int x = block->GetPositionX();
+    int z = block->GetPositionZ();
 
-        levelGrid[Level::GROUND][z][x] = nullptr;
+    SetGridObject(Level::GROUND, x, z, nullptr);
+    MarkTileDirty(x, z);
+    levelMesh.MarkDirty(x, z);
 
+    if(tiles.Get(Level::ABOVE, x, z) == GameObject::GRASS)
+    {
         GameObject *above = GetGameObjectFromGrid(Level::ABOVE, x, z);
-        if(above != nullptr && above->GetObject() == GameObject::GRASS)
+        above->SetState(GameObject::MOVING);
+        above->SetVelocity(glm::vec3(0.0, -FallSpeed, 0.0));
+        above->SetStatic(false);
+        sinkingObjects.push_back(gameObjects.GetHandle(above));
+
+        SetGridObject(Level::ABOVE, x, z, nullptr);
+    }
+}
+
+void Game::DestroySunkObjects()
+{
+    // Only falling objects can drop out of the level, so the cost follows how many are falling
+    for(size_t i = 0; i < sinkingObjects.size();)
+    {
+        GameObject *gameObject = gameObjects.Get(sinkingObjects[i]);
+        if(gameObject != nullptr && gameObject->GetPosition().y >= SunkDepth)
         {
-            above->SetState(GameObject::MOVING);
-            above->SetVelocity(glm::vec3(0.0, -0.1, 0.0));
+            ++i;
+            continue;
+        }
+
+        if(gameObject != nullptr)
+        {
+            // A fallen enemy still owns its cell, clear it so the grid never holds a stale handle
+            int x = gameObject->GetPositionX();
+            int z = gameObject->GetPositionZ();
+            if(GetGameObjectFromGrid(Level::ABOVE, x, z) == gameObject)
+            {
+                SetGridObject(Level::ABOVE, x, z, nullptr);
+            }
 
-            levelGrid[Level::ABOVE][z][x] = nullptr;
+            gameObjects.Destroy(sinkingObjects[i]);
         }
 
-        deleteArea.erase(deleteArea.begin());
+        sinkingObjects[i] = sinkingObjects.back();
+        sinkingObjects.pop_back();
+    }
+}
+
+void Game::RemoveStrandedCracks()
+{
+    std::vector<int> strandedTiles;
+    tiles.FindStrandedTiles(Level::GROUND, &strandedTiles);
+
+    for(int tile : strandedTiles)
+    {
+        SinkBlock(GetGameObjectFromGrid(Level::GROUND, tile % levelWidth, tile / levelWidth));
     }
 }
 
 void Game::HandleKeyboardInput(SDL_Keycode keyCode, SDL_EventType eventType)
 {
+    GameObject *player = GetPlayer();
+
     switch(keyCode)
     {
 	case SDLK_ESCAPE:
@@ -605,7 +913,7 @@ void Game::HandleKeyboardInput(SDL_Keycode keyCode, SDL_EventType eventType)
         if(eventType == SDL_KEYDOWN)
         {
             player->SetState(GameObject::MOVING);
-            player->SetVelocity(glm::vec3(0.0, 0.0, -0.1));
+            player->SetVelocity(glm::vec3(0.0, 0.0, -PlayerSpeed));
         }
         else
         {
@@ -618,7 +926,7 @@ void Game::HandleKeyboardInput(SDL_Keycode keyCode, SDL_EventType eventType)
         if(eventType == SDL_KEYDOWN)
         {
             player->SetState(GameObject::MOVING);
-            player->SetVelocity(glm::vec3(-0.1, 0.0, 0.0));
+            player->SetVelocity(glm::vec3(-PlayerSpeed, 0.0, 0.0));
         }
         else
         {
@@ -631,7 +939,7 @@ void Game::HandleKeyboardInput(SDL_Keycode keyCode, SDL_EventType eventType)
         if(eventType == SDL_KEYDOWN)
         {
             player->SetState(GameObject::MOVING);
-            player->SetVelocity(glm::vec3(0.0, 0.0, 0.1));
+            player->SetVelocity(glm::vec3(0.0, 0.0, PlayerSpeed));
         }
         else
         {
@@ -644,7 +952,7 @@ void Game::HandleKeyboardInput(SDL_Keycode keyCode, SDL_EventType eventType)
         if(eventType == SDL_KEYDOWN)
         {
             player->SetState(GameObject::MOVING);
-            player->SetVelocity(glm::vec3(0.1, 0.0, 0.0));
+            player->SetVelocity(glm::vec3(PlayerSpeed, 0.0, 0.0));
         }
         else
         {
@@ -654,9 +962,7 @@ void Game::HandleKeyboardInput(SDL_Keycode keyCode, SDL_EventType eventType)
     case SDLK_SPACE:
         if(eventType == SDL_KEYDOWN)
         {
-            GameObject *block = GetGameObjectFromGrid(Level::GROUND, player->GetPositionX(), player->GetPositionZ());
-
-            if(block->GetObject() == GameObject::HOLE)
+            if(tiles.Get(Level::GROUND, player->GetPositionX(), player->GetPositionZ()) == GameObject::HOLE)
             {
                 CreateCrack();
             }
@@ -668,6 +974,20 @@ void Game::HandleKeyboardInput(SDL_Keycode keyCode, SDL_EventType eventType)
             PushEnemy();
         }
         break;
+    case SDLK_F3:
+        if(eventType == SDL_KEYDOWN)
+        {
+            showRenderStats = !showRenderStats;
+        }
+        break;
+    case SDLK_F4:
+        if(eventType == SDL_KEYDOWN)
+        {
+            TextureCache::PrintReport(std::cout);
+            blockTextures.PrintReport(std::cout);
+            PrintMemoryReport(std::cout);
+        }
+        break;
     case SDLK_v:
         if(eventType == SDL_KEYDOWN)
         {
@@ -688,8 +1008,30 @@ void Game::HandleKeyboardInput(SDL_Keycode keyCode, SDL_EventType eventType)
     }
 }
 
+void Game::SimulateInput()
+{
+    // Stand-in for a player in headless runs: every few ticks press a random key and release the last one
+    static const SDL_Keycode keys[] = {SDLK_w, SDLK_a, SDLK_s, SDLK_d, SDLK_SPACE, SDLK_f};
+    static const int keyCount = sizeof(keys) / sizeof(keys[0]);
+    static SDL_Keycode heldKey = SDLK_UNKNOWN;
+
+    if(rand() % 30 != 0)
+    {
+        return;
+    }
+
+    if(heldKey != SDLK_UNKNOWN)
+    {
+        HandleKeyboardInput(heldKey, SDL_KEYUP);
+    }
+
+    heldKey = keys[rand() % keyCount];
+    HandleKeyboardInput(heldKey, SDL_KEYDOWN);
+}
+
 void Game::CreateCrack()
 {
+    GameObject *player = GetPlayer();
     bool crack = false;
     std::vector<GameObject*> grassBlocks;
 
@@ -718,24 +1060,24 @@ void Game::CreateCrack()
         break;
     }
 
-    GameObject *ground = nullptr;
-    GameObject *above = nullptr;
+    GameObject::Object ground = GameObject::OBJECT_NULL;
+    GameObject::Object above = GameObject::OBJECT_NULL;
     
-    while(!crack && (above == nullptr || above->GetObject() != GameObject::GRASS))
+    while(!crack && above != GameObject::GRASS)
     {
         x += ox;
         z += oz;
         
-        ground = GetGameObjectFromGrid(Level::GROUND, x, z);
-        above = GetGameObjectFromGrid(Level::ABOVE, x, z);
+        ground = tiles.Get(Level::GROUND, x, z);
+        above = tiles.Get(Level::ABOVE, x, z);
 
-        if(ground == nullptr || ground->GetObject() == GameObject::HOLE || ground->GetObject() == GameObject::CRACK)
+        if(ground == GameObject::OBJECT_NULL || ground == GameObject::HOLE || ground == GameObject::CRACK)
         {
             crack = true;
         }
-        else if(ground->GetObject() == GameObject::GRASS)
+        else if(ground == GameObject::GRASS)
         {
-            grassBlocks.push_back(ground);
+            grassBlocks.push_back(GetGameObjectFromGrid(Level::GROUND, x, z));
         }
     } 
 
@@ -743,7 +1085,8 @@ void Game::CreateCrack()
     {
         for(GameObject* block : grassBlocks)
         {
-            block->SetModel(models[GameObject::CRACK], GameObject::CRACK);
+            SetBlockObject(block, GameObject::CRACK);
+            MarkTileDirty(block->GetPositionX(), block->GetPositionZ());
         }
         AdjustBlocksTexture();
         FloodFill();
@@ -753,6 +1096,7 @@ void Game::CreateCrack()
 
 void Game::PushEnemy()
 {
+    GameObject *player = GetPlayer();
     int x = player->GetPositionX();
     int z = player->GetPositionZ();
     int ox;
@@ -778,21 +1122,20 @@ void Game::PushEnemy()
         break;
     }
 
-    GameObject *near = GetGameObjectFromGrid(Level::ABOVE, x + ox, z + oz);
-    GameObject *far = GetGameObjectFromGrid(Level::ABOVE, x + (ox*2), z + (oz*2));
-
-    if(near != nullptr && near->GetObject() == GameObject::ENEMY)
+    if(tiles.Get(Level::ABOVE, x + ox, z + oz) == GameObject::ENEMY)
     {
-        near->SetVelocity(glm::vec3((float)ox, 0.0, (float)oz));
+        GameObject *near = GetGameObjectFromGrid(Level::ABOVE, x + ox, z + oz);
+        near->SetVelocity(glm::vec3(ox * PushSpeed, 0.0, oz * PushSpeed));
         near->SetState(GameObject::PUSHED);
         int x = near->GetPositionX();
         int z = near->GetPositionZ();
         near->SetTargetX(x + (ox*2));
         near->SetTargetZ(z + (oz*2));
     }
-    else if(far != nullptr && far->GetObject() == GameObject::ENEMY)
+    else if(tiles.Get(Level::ABOVE, x + (ox*2), z + (oz*2)) == GameObject::ENEMY)
     {
-        far->SetVelocity(glm::vec3((float)ox, 0.0, (float)oz));
+        GameObject *far = GetGameObjectFromGrid(Level::ABOVE, x + (ox*2), z + (oz*2));
+        far->SetVelocity(glm::vec3(ox * PushSpeed, 0.0, oz * PushSpeed));
         far->SetState(GameObject::PUSHED);
         int x = far->GetPositionX();
         int z = far->GetPositionZ();
@@ -803,29 +1146,18 @@ void Game::PushEnemy()
 
 void Game::Update()
 {
-    std::vector<GameObject*> objects;
-    objects.assign(gameObjects.begin(), gameObjects.end());
-    for(int i = 0; i < objects.size(); ++i)
-    {
-        glm::vec3 position(objects[i]->GetModelMatrix()[3]);
-
-        if(position.y < -15.0 && objects[i]->GetObject() != GameObject::PLAYER)
-        {
-            gameObjects.erase(std::remove(gameObjects.begin(), gameObjects.end(), objects[i]), gameObjects.end());
-
-            delete objects[i];
-            objects[i] = nullptr;
-        }
-    }
-
     CheckPlayerCollision();
 
+    GameObject *player = GetPlayer();
     std::vector<GameObject*> actors;
-    actors.assign(enemies.begin(), enemies.end());
+    for(GameObjectHandle enemy : enemies)
+    {
+        actors.push_back(gameObjects.Get(enemy));
+    }
     actors.push_back(player);
     for(GameObject *actor : actors)
     {
-        glm::vec3 position(actor->GetModelMatrix()[3]);
+        glm::vec3 position(actor->GetPosition());
         int x = (int)std::round(position.x / 2.0);
         int z = (int)std::round(position.z / 2.0);
 
@@ -841,32 +1173,33 @@ void Game::Update()
         if(x != actor->GetPositionX() ||
            z != actor->GetPositionZ())
         {
-            GameObject *object = GetGameObjectFromGrid(Level::ABOVE, actor->GetPositionX(), actor->GetPositionZ());
-            GameObject *above = GetGameObjectFromGrid(Level::ABOVE, x, z);
+            GameObject::Object object = tiles.Get(Level::ABOVE, actor->GetPositionX(), actor->GetPositionZ());
+            GameObject::Object above = tiles.Get(Level::ABOVE, x, z);
 
-            if(above != nullptr &&
-                ((actor->GetObject() == GameObject::PLAYER && above->GetObject() == GameObject::ENEMY) ||
-               (actor->GetObject() == GameObject::ENEMY && above->GetObject() == GameObject::PLAYER)))
+            if((actor->GetObject() == GameObject::PLAYER && above == GameObject::ENEMY) ||
+               (actor->GetObject() == GameObject::ENEMY && above == GameObject::PLAYER))
             {
                 actor->SetState(GameObject::INERT);
-                above->SetState(GameObject::INERT);
+                GetGameObjectFromGrid(Level::ABOVE, x, z)->SetState(GameObject::INERT);
                 state = GameState::OVER;
                 break;
             }
 
-            if(object != nullptr && (object->GetObject() == GameObject::PLAYER || object->GetObject() == GameObject::ENEMY))
+            if(object == GameObject::PLAYER || object == GameObject::ENEMY)
             {
-                levelGrid[Level::ABOVE][actor->GetPositionZ()][actor->GetPositionX()] = nullptr;
-                levelGrid[Level::ABOVE][z][x] = actor;
+                SetGridObject(Level::ABOVE, actor->GetPositionX(), actor->GetPositionZ(), nullptr);
+                if(tiles.IsInside(x, z))
+                {
+                    SetGridObject(Level::ABOVE, x, z, actor);
+                }
                 actor->SetPositionX(x);
                 actor->SetPositionZ(z);
             }
         }
         // check if position is valid
-        GameObject *ground = GetGameObjectFromGrid(Level::GROUND, x, z);
-        if(ground == nullptr)
+        if(tiles.Get(Level::GROUND, x, z) == GameObject::OBJECT_NULL)
         {
-            actor->SetVelocity(glm::vec3(0.0, -0.1, 0.0));
+            actor->SetVelocity(glm::vec3(0.0, -FallSpeed, 0.0));
             actor->SetState(GameObject::MOVING);
             if(actor->GetObject() == GameObject::PLAYER)
             {
@@ -874,7 +1207,8 @@ void Game::Update()
             }
             else if(actor->GetObject() == GameObject::ENEMY)
             {
-                enemies.erase(std::remove(enemies.begin(), enemies.end(), actor), enemies.end());
+                enemies.erase(std::remove(enemies.begin(), enemies.end(), gameObjects.GetHandle(actor)), enemies.end());
+                sinkingObjects.push_back(gameObjects.GetHandle(actor));
             }
         }
     }
@@ -896,17 +1230,14 @@ void Game::Update()
 
 void Game::CheckPlayerCollision()
 {
+    GameObject *player = GetPlayer();
     int x = player->GetPositionX();
     int z = player->GetPositionZ();
 
-    GameObject *bottom = GetGameObjectFromGrid(Level::GROUND, x, z + 1);
-    GameObject *bottomA = GetGameObjectFromGrid(Level::ABOVE, x, z + 1);
-    GameObject *right = GetGameObjectFromGrid(Level::GROUND, x + 1, z);
-    GameObject *rightA = GetGameObjectFromGrid(Level::ABOVE, x + 1, z);
-    GameObject *top = GetGameObjectFromGrid(Level::GROUND, x, z - 1);
-    GameObject *topA = GetGameObjectFromGrid(Level::ABOVE, x, z - 1);
-    GameObject *left = GetGameObjectFromGrid(Level::GROUND, x - 1, z);
-    GameObject *leftA = GetGameObjectFromGrid(Level::ABOVE, x - 1, z);
+    GameObject::Object bottomA = tiles.Get(Level::ABOVE, x, z + 1);
+    GameObject::Object rightA = tiles.Get(Level::ABOVE, x + 1, z);
+    GameObject::Object topA = tiles.Get(Level::ABOVE, x, z - 1);
+    GameObject::Object leftA = tiles.Get(Level::ABOVE, x - 1, z);
 
     if(player->GetState() == GameObject::MOVING)
     {
@@ -914,28 +1245,28 @@ void Game::CheckPlayerCollision()
 
         if(velocity.x == 0.0 && velocity.z > 0.0)
         {
-            if(bottomA != nullptr && bottomA->GetObject() == GameObject::GRASS)
+            if(bottomA == GameObject::GRASS)
             {
                 player->SetState(GameObject::INERT);
             }
         }
         else if(velocity.x == 0.0 && velocity.z < 0.0)
         {
-            if(topA != nullptr && topA->GetObject() == GameObject::GRASS)
+            if(topA == GameObject::GRASS)
             {
                 player->SetState(GameObject::INERT);
             }
         }
         else if(velocity.x > 0.0 && velocity.z == 0.0)
         {
-            if(rightA != nullptr && rightA->GetObject() == GameObject::GRASS)
+            if(rightA == GameObject::GRASS)
             {
                 player->SetState(GameObject::INERT);
             }
         }
         else if(velocity.x < 0.0 && velocity.z == 0.0)
         {
-            if(leftA != nullptr && leftA->GetObject() == GameObject::GRASS)
+            if(leftA == GameObject::GRASS)
             {
                 player->SetState(GameObject::INERT);
             }
@@ -945,19 +1276,21 @@ void Game::CheckPlayerCollision()
 
 void Game::UpdateEnemies()
 {
-    for(GameObject *enemy : enemies)
+    GameObject *player = GetPlayer();
+    for(GameObjectHandle enemyHandle : enemies)
     {
+        GameObject *enemy = gameObjects.Get(enemyHandle);
         int x = enemy->GetPositionX();
         int z = enemy->GetPositionZ();
             
-        GameObject *bottom = GetGameObjectFromGrid(Level::GROUND, x, z + 1);
-        GameObject *bottomA = GetGameObjectFromGrid(Level::ABOVE, x, z + 1);
-        GameObject *right = GetGameObjectFromGrid(Level::GROUND, x + 1, z);
-        GameObject *rightA = GetGameObjectFromGrid(Level::ABOVE, x + 1, z);
-        GameObject *top = GetGameObjectFromGrid(Level::GROUND, x, z - 1);
-        GameObject *topA = GetGameObjectFromGrid(Level::ABOVE, x, z - 1);
-        GameObject *left = GetGameObjectFromGrid(Level::GROUND, x - 1, z);
-        GameObject *leftA = GetGameObjectFromGrid(Level::ABOVE, x - 1, z);
+        GameObject::Object bottom = tiles.Get(Level::GROUND, x, z + 1);
+        GameObject::Object bottomA = tiles.Get(Level::ABOVE, x, z + 1);
+        GameObject::Object right = tiles.Get(Level::GROUND, x + 1, z);
+        GameObject::Object rightA = tiles.Get(Level::ABOVE, x + 1, z);
+        GameObject::Object top = tiles.Get(Level::GROUND, x, z - 1);
+        GameObject::Object topA = tiles.Get(Level::ABOVE, x, z - 1);
+        GameObject::Object left = tiles.Get(Level::GROUND, x - 1, z);
+        GameObject::Object leftA = tiles.Get(Level::ABOVE, x - 1, z);
 
         if(enemy->GetState() == GameObject::PUSHED)
         {
@@ -965,32 +1298,28 @@ void Game::UpdateEnemies()
 
             if(velocity.x == 0.0 && velocity.z > 0.0)
             {
-                if((bottom != nullptr && (bottom->GetObject() == GameObject::HOLE || bottom->GetObject() == GameObject::CRACK)) ||
-                   (bottomA != nullptr && bottomA->GetObject() == GameObject::GRASS))
+                if(bottom == GameObject::HOLE || bottom == GameObject::CRACK || bottomA == GameObject::GRASS)
                 {
                     enemy->SetState(GameObject::INERT);
                 }
             }
             else if(velocity.x == 0.0 && velocity.z < 0.0)
             {
-                if((top != nullptr && (top->GetObject() == GameObject::HOLE || top->GetObject() == GameObject::CRACK)) ||
-                   (topA != nullptr && topA->GetObject() == GameObject::GRASS))
+                if(top == GameObject::HOLE || top == GameObject::CRACK || topA == GameObject::GRASS)
                 {
                     enemy->SetState(GameObject::INERT);
                 }
             }
             else if(velocity.x > 0.0 && velocity.z == 0.0)
             {
-                if((right != nullptr && (right->GetObject() == GameObject::HOLE || right->GetObject() == GameObject::CRACK)) ||
-                   (rightA != nullptr && rightA->GetObject() == GameObject::GRASS))
+                if(right == GameObject::HOLE || right == GameObject::CRACK || rightA == GameObject::GRASS)
                 {
                     enemy->SetState(GameObject::INERT);
                 }
             }
             else if(velocity.x < 0.0 && velocity.z == 0.0)
             {
-                if((left != nullptr && (left->GetObject() == GameObject::HOLE || left->GetObject() == GameObject::CRACK)) ||
-                   (leftA != nullptr && leftA->GetObject() == GameObject::GRASS))
+                if(left == GameObject::HOLE || left == GameObject::CRACK || leftA == GameObject::GRASS)
                 {
                     enemy->SetState(GameObject::INERT);
                 }
@@ -1000,19 +1329,19 @@ void Game::UpdateEnemies()
         {
 
             std::vector<GameObject::Orientation> possibleActions;
-            if(bottom != nullptr && bottom->GetObject() == GameObject::GRASS && (bottomA == nullptr || bottomA->GetObject() != GameObject::GRASS || bottomA->GetObject() != GameObject::ENEMY))
+            if(bottom == GameObject::GRASS && (bottomA == GameObject::OBJECT_NULL || bottomA != GameObject::GRASS || bottomA != GameObject::ENEMY))
             {
                 possibleActions.push_back(GameObject::DOWN);
             }
-            if(right != nullptr && right->GetObject() == GameObject::GRASS && (rightA == nullptr || rightA->GetObject() != GameObject::GRASS || rightA->GetObject() != GameObject::ENEMY))
+            if(right == GameObject::GRASS && (rightA == GameObject::OBJECT_NULL || rightA != GameObject::GRASS || rightA != GameObject::ENEMY))
             {
                 possibleActions.push_back(GameObject::RIGHT);
             }
-            if(top != nullptr && top->GetObject() == GameObject::GRASS && (topA == nullptr || topA->GetObject() != GameObject::GRASS || topA->GetObject() != GameObject::ENEMY))
+            if(top == GameObject::GRASS && (topA == GameObject::OBJECT_NULL || topA != GameObject::GRASS || topA != GameObject::ENEMY))
             {
                 possibleActions.push_back(GameObject::UP);
             }
-            if(left != nullptr && left->GetObject() == GameObject::GRASS && (leftA == nullptr || leftA->GetObject() != GameObject::GRASS || leftA->GetObject() != GameObject::ENEMY))
+            if(left == GameObject::GRASS && (leftA == GameObject::OBJECT_NULL || leftA != GameObject::GRASS || leftA != GameObject::ENEMY))
             {
                 possibleActions.push_back(GameObject::LEFT);
             }
@@ -1083,7 +1412,7 @@ void Game::UpdateEnemies()
                 case GameObject::UP:
                     enemy->Rotate(180.0);
                     enemy->SetOrientation(GameObject::UP);
-                    enemy->SetVelocity(glm::vec3(0.0, 0.0, -0.075));
+                    enemy->SetVelocity(glm::vec3(0.0, 0.0, -EnemySpeed));
                     enemy->SetState(GameObject::PUSHED);
                     enemy->SetTargetX(x);
                     enemy->SetTargetZ(z - 1);
@@ -1091,7 +1420,7 @@ void Game::UpdateEnemies()
                 case GameObject::LEFT:
                     enemy->Rotate(270.0);
                     enemy->SetOrientation(GameObject::LEFT);
-                    enemy->SetVelocity(glm::vec3(-0.075, 0.0, 0.0));
+                    enemy->SetVelocity(glm::vec3(-EnemySpeed, 0.0, 0.0));
                     enemy->SetState(GameObject::PUSHED);
                     enemy->SetTargetX(x - 1);
                     enemy->SetTargetZ(z);
@@ -1099,7 +1428,7 @@ void Game::UpdateEnemies()
                 case GameObject::DOWN:
                     enemy->Rotate(0.0);
                     enemy->SetOrientation(GameObject::DOWN);
-                    enemy->SetVelocity(glm::vec3(0.0, 0.0, 0.075));
+                    enemy->SetVelocity(glm::vec3(0.0, 0.0, EnemySpeed));
                     enemy->SetState(GameObject::PUSHED);
                     enemy->SetTargetX(x);
                     enemy->SetTargetZ(z + 1);
@@ -1107,7 +1436,7 @@ void Game::UpdateEnemies()
                 case GameObject::RIGHT:
                     enemy->Rotate(90.0);
                     enemy->SetOrientation(GameObject::RIGHT);
-                    enemy->SetVelocity(glm::vec3(0.075, 0.0, 0.0));
+                    enemy->SetVelocity(glm::vec3(EnemySpeed, 0.0, 0.0));
                     enemy->SetState(GameObject::PUSHED);
                     enemy->SetTargetX(x + 1);
                     enemy->SetTargetZ(z);
@@ -1118,9 +1447,10 @@ void Game::UpdateEnemies()
     }
 }
 
-void Game::UpdateCamera()
+void Game::UpdateCamera(float alpha)
 {
-    glm::vec3 position(player->GetModelMatrix()[3]);
+    GameObject *player = GetPlayer();
+    glm::vec3 position(player->GetPosition(alpha));
     int ox;
     int oz;
 
@@ -1156,8 +1486,51 @@ void Game::UpdateCamera()
 
 int main(int argc, char *argv[])
 {
-    Game *game = new Game();
-    game->Run();
+    bool headless = false;
+    int ticks = 10000;
+    int tickRate = 60;
+    Game::IslandRule islandRule = Game::KEEP_PLAYER_ISLAND;
+    std::string levelDirectory = Game::LevelDirectory;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string argument(argv[i]);
+        if(argument == "--headless")
+        {
+            headless = true;
+        }
+        else if(argument == "--ticks" && i + 1 < argc)
+        {
+            ticks = std::atoi(argv[++i]);
+        }
+        else if(argument == "--tickrate" && i + 1 < argc)
+        {
+            tickRate = std::atoi(argv[++i]);
+        }
+        else if(argument == "--islands" && i + 1 < argc)
+        {
+            islandRule = std::string(argv[++i]) == "largest" ? Game::KEEP_LARGEST_ISLAND : Game::KEEP_PLAYER_ISLAND;
+        }
+        else if(argument == "--level" && i + 1 < argc)
+        {
+            levelDirectory = std::string(argv[++i]) + "/";
+        }
+        else if(argument == "--seed" && i + 1 < argc)
+        {
+            srand(std::atoi(argv[++i]));
+        }
+    }
+
+    Game *game = new Game(headless, tickRate, islandRule, levelDirectory);
+    if(headless)
+    {
+        game->Simulate(ticks);
+    }
+    else
+    {
+        game->Run();
+    }
 
+    delete game;
     return 0;
 }
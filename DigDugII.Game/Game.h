@@ -2,6 +2,7 @@
 
 #include <cmath>
 #include <algorithm>
+#include <chrono>
 #include <GL/glew.h>
 #include <SDL.h>
 #include <SDL_opengl.h>
@@ -11,15 +12,35 @@
 #include "Shader.h"
 #include "Model.h"
 #include "GameObject.h"
+#include "GameObjectPool.h"
 #include "Camera.h"
+#include "AllocationCounter.h"
+#include "TileGrid.h"
+#include "LevelMesh.h"
+#include "RenderQueue.h"
+#include "RenderState.h"
+#include "TextureArray.h"
+#include "AssetLoader.h"
 
 class Game
 {
 public:
-    Game();
+    // Which piece of ground stays up when a crack splits it, every other piece sinks
+    enum IslandRule
+    {
+        KEEP_PLAYER_ISLAND,
+        KEEP_LARGEST_ISLAND
+    };
+
+    // Directory holding level_ground.png and level_above.png, the level size is read from the images
+    static const std::string LevelDirectory;
+
+    Game(bool headless = false, int tickRate = 60, IslandRule islandRule = KEEP_PLAYER_ISLAND,
+         const std::string &levelDirectory = LevelDirectory);
     ~Game();
 
     void Run();
+    void Simulate(int ticks);
 
 private:
     enum Level
@@ -35,33 +56,104 @@ private:
         WIN
     };
 
-    static const int LevelSize = 20;
-    static const std::string LevelGroundPath;
-    static const std::string LevelAbovePath;
+    // Neighbour of a hole or crack block, one base 3 digit per side indexes the tile shape table
+    enum Neighbour
+    {
+        SOLID,
+        OPEN,
+        EMPTY
+    };
+
+    // Offset from HOLE or CRACK to the model that joins a block with its neighbours
+    enum TileVariant
+    {
+        TILE_SINGLE,
+        TILE_ONE,
+        TILE_TWO,
+        TILE_TWO_L,
+        TILE_THREE,
+        TILE_FOUR
+    };
+
+    struct TileShape
+    {
+        int variant;
+        float degrees;
+    };
+
+    static const int TileShapeCount = 81;
+    static const std::string LevelGroundFile;
+    static const std::string LevelAboveFile;
+    static const float PlayerSpeed;
+    static const float EnemySpeed;
+    static const float PushSpeed;
+    static const int MinTickRate;
+    static const float FallSpeed;
+    static const float SunkDepth;
+    static const double MaxFrameTime;
+    static const double RenderStatsInterval;
+    static TileShape tileShapes[TileShapeCount];
+
+    struct Uniforms
+    {
+        int projection;
+        int view;
+        int viewPosition;
+    };
 
+    std::string levelGroundPath;
+    std::string levelAbovePath;
+    int levelWidth;
+    int levelHeight;
     GameState state;
+    IslandRule islandRule;
+    bool headless;
+    double tickDuration;
     SDL_DisplayMode display;
     SDL_Window *window;
     SDL_GLContext context;
     Shader *shader;
+    Uniforms uniforms;
     Camera *mainCamera;
     Camera *camera;
     Camera *fpsCamera;
     Camera *thirdCamera;
     std::vector<Model*> models;
-    std::vector<GameObject*> gameObjects;
-    GameObject *levelGrid[2][LevelSize][LevelSize];
-    GameObject *player;
-    std::vector<GameObject*> enemies;
+    TextureArray blockTextures;
+    GameObjectPool gameObjects;
+    std::vector<GameObjectHandle> levelGrid[2];
+    TileGrid tiles;
+    LevelMesh levelMesh;
+    RenderQueue renderQueue;
+    RenderState renderState;
+    bool showRenderStats;
+    // Heap allocations made while drawing since the last stats line, baking is left out as it may allocate
+    unsigned long long drawAllocations;
+    std::vector<GameObject*> bakeObjects;
+    std::vector<bool> dirtyTiles;
+    std::vector<int> dirtyTileList;
+    GameObjectHandle playerHandle;
+    std::vector<GameObjectHandle> enemies;
+    std::vector<GameObjectHandle> sinkingObjects;
 
+    void LoadUniforms();
     void LoadModels();
     void LoadLevel();
     void MapImageToLevel(FIBITMAP * image, Level level);
     bool ExistsFloorAt(int x, int y);
     GameObject* GetGameObjectFromGrid(Level level, int x, int z);
+    void SetGridObject(Level level, int x, int z, GameObject *gameObject);
+    GameObject* GetPlayer();
+    void SetBlockObject(GameObject *block, GameObject::Object object);
+    static void LoadTileShapes();
+    Neighbour GetNeighbour(int x, int z);
+    void MarkTileDirty(int x, int z);
     void AdjustBlocksTexture();
     void FloodFill();
-    void Flood(GameObject* block, std::vector<GameObject*> *grassBlocks, std::vector<GameObject*> *area);
+    void Flood(GameObject* block, int label, std::vector<int> *labels, std::vector<GameObject*> *blocks);
+    int GetPlayerIsland(const std::vector<int> &labels, const std::vector<size_t> &islandStarts);
+    void SinkBlock(GameObject *block);
+    void DestroySunkObjects();
     void RemoveStrandedCracks();
     void HandleKeyboardInput(SDL_Keycode keyCode, SDL_EventType eventType);
     void CreateCrack();
@@ -69,5 +161,10 @@ private:
     void Update();
     void CheckPlayerCollision();
     void UpdateEnemies();
-    void UpdateCamera();
+    void UpdateCamera(float alpha);
+    void Tick();
+    void Render(float alpha);
+    void BakeLevelMesh();
+    void PrintMemoryReport(std::ostream &stream);
+    void SimulateInput();
 };
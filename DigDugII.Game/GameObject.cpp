@@ -1,129 +1,150 @@
 #include "GameObject.h"
+#include "GameObjectPool.h"
 
-GameObject::GameObject(Shader * shader, Model * model, glm::vec3 position, Object object, int positionX, int positionZ)
-    : shader(shader),
-    model(model),
-    object(object),
-    velocity(glm::vec3(0.0, 0.0, 0.0)),
-    state(State::INERT),
-    positionX(positionX),
-    positionZ(positionZ),
-    orientation(Orientation::DOWN)
+GameObject::GameObject(GameObjectPool *pool, unsigned index)
+    : pool(pool),
+    index(index)
 {
-    transformationMatrix = glm::translate(transformationMatrix, position);
 }
 
 GameObject::~GameObject()
 {
 }
 
-void GameObject::Update()
+void GameObject::Rotate(float angle)
 {
-    if(state == State::MOVING || state == State::PUSHED)
-    {
-        transformationMatrix = glm::translate(transformationMatrix, velocity);
-    }
+    int turns = (int)std::round(angle / 90.0f) % GameObjectPool::QuarterTurns;
+    pool->rotations[index] = (unsigned char)(turns < 0 ? turns + GameObjectPool::QuarterTurns : turns);
+    pool->modelMatricesDirty[index] = true;
 }
 
-void GameObject::Draw()
+const glm::mat4& GameObject::GetModelMatrix()
 {
-    modelMatrix = GetModelMatrix();
-    shader->SetUniform("model", modelMatrix);
-    model->Draw(shader);
+    return pool->GetModelMatrix(index);
 }
 
-void GameObject::Rotate(float angle)
+glm::mat4 GameObject::GetModelMatrix(float alpha)
+{
+    // Blend between the last two simulation ticks so motion stays smooth at any frame rate
+    glm::mat4 interpolated(pool->GetModelMatrix(index));
+    interpolated[3] = glm::vec4(GetPosition(alpha), 1.0);
+    return interpolated;
+}
+
+const glm::mat3& GameObject::GetNormalMatrix()
 {
-    rotationMatrix = glm::orientate4(glm::vec3(0.0, 0.0, glm::radians(angle)));
+    return pool->GetNormalMatrix(index);
 }
 
-glm::mat4 GameObject::GetModelMatrix()
+glm::vec3 GameObject::GetPosition()
 {
-    return transformationMatrix * rotationMatrix * scaleMatrix;
+    return pool->positions[index];
+}
+
+glm::vec3 GameObject::GetPosition(float alpha)
+{
+    return glm::mix(pool->previousPositions[index], pool->positions[index], alpha);
 }
 
 GameObject::Object GameObject::GetObject()
 {
-    return this->object;
+    return pool->objectTypes[index];
+}
+
+Model * GameObject::GetModel()
+{
+    return pool->models[index];
+}
+
+bool GameObject::IsStatic()
+{
+    return pool->dynamicIndices[index] == GameObjectPool::StaticObject;
 }
 
 GameObject::Orientation GameObject::GetOrientation()
 {
-    return orientation;
+    return pool->orientations[index];
 }
 
 GameObject::State GameObject::GetState()
 {
-    return state;
+    return pool->states[index];
 }
 
 glm::vec3 GameObject::GetVelocity()
 {
-    return velocity;
+    return pool->velocities[index];
 }
 
 int GameObject::GetPositionX()
 {
-    return positionX;
+    return pool->cells[index].x;
 }
 
 int GameObject::GetPositionZ()
 {
-    return positionZ;
+    return pool->cells[index].y;
 }
 
 int GameObject::GetTargetX()
 {
-    return targetX;
+    return pool->targets[index].x;
 }
 
 int GameObject::GetTargetZ()
 {
-    return targetZ;
+    return pool->targets[index].y;
 }
 
 void GameObject::SetModel(Model * model, Object object)
 {
-    this->model = model;
-    this->object = object;
+    pool->models[index] = model;
+    pool->objectTypes[index] = object;
 }
 
 void GameObject::SetOrientation(Orientation orientation)
 {
-    this->orientation = orientation;
+    pool->orientations[index] = orientation;
 }
 
 void GameObject::SetVelocity(glm::vec3 velocity)
 {
-    this->velocity = velocity;
+    pool->velocities[index] = velocity;
 }
 
 void GameObject::SetScale(glm::vec3 scale)
 {
-    scaleMatrix = glm::scale(scaleMatrix, scale);
+    pool->scales[index] *= scale;
+    pool->modelMatricesDirty[index] = true;
+}
+
+void GameObject::SetStatic(bool isStatic)
+{
+    // Static objects are baked into the level mesh and skipped by the instanced path
+    pool->SetStatic(index, isStatic);
 }
 
 void GameObject::SetState(State state)
 {
-    this->state = state;
+    pool->states[index] = state;
 }
 
 void GameObject::SetPositionX(int positionX)
 {
-    this->positionX = positionX;
+    pool->cells[index].x = positionX;
 }
 
 void GameObject::SetPositionZ(int positionZ)
 {
-    this->positionZ = positionZ;
+    pool->cells[index].y = positionZ;
 }
 
 void GameObject::SetTargetX(int targetX)
 {
-    this->targetX = targetX;
+    pool->targets[index].x = targetX;
 }
 
 void GameObject::SetTargetZ(int targetZ)
 {
-    this->targetZ = targetZ;
+    pool->targets[index].y = targetZ;
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cmath>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/euler_angles.hpp>
@@ -8,6 +9,9 @@
 #include "Shader.h"
 #include "Model.h"
 
+class GameObjectPool;
+
+// View of one object in a GameObjectPool, its components live in the pool's arrays
 class GameObject
 {
 public:
@@ -46,15 +50,19 @@ public:
         LEFT
     };
 
-    GameObject(Shader * shader, Model * model, glm::vec3 position, Object object, int positionX, int positionY);
+    GameObject(GameObjectPool *pool, unsigned index);
     ~GameObject();
 
-    void Update();
-    void Draw();
     void Rotate(float angle);
 
-    glm::mat4 GetModelMatrix();
+    const glm::mat4& GetModelMatrix();
+    glm::mat4 GetModelMatrix(float alpha);
+    const glm::mat3& GetNormalMatrix();
+    glm::vec3 GetPosition();
+    glm::vec3 GetPosition(float alpha);
     GameObject::Object GetObject();
+    Model* GetModel();
+    bool IsStatic();
     GameObject::Orientation GetOrientation();
     GameObject::State GetState();
     glm::vec3 GetVelocity();
@@ -67,6 +75,7 @@ public:
     void SetOrientation(Orientation orientation);
     void SetVelocity(glm::vec3 velocity);
     void SetScale(glm::vec3 scale);
+    void SetStatic(bool isStatic);
     void SetState(State state);
     void SetPositionX(int positionX);
     void SetPositionZ(int positionZ);
@@ -74,19 +83,6 @@ public:
     void SetTargetZ(int targetZ);
 
 private:
-    Shader *shader;
-    Model *model;
-    glm::mat4 modelMatrix;
-    glm::mat4 transformationMatrix;
-    glm::mat4 rotationMatrix;
-    glm::mat4 scaleMatrix;
-    glm::vec3 velocity;
-    Object object;
-    State state;
-    Orientation orientation;
-    int positionX;
-    int positionZ;
-    int targetX;
-    int targetZ;
+    GameObjectPool *pool;
+    unsigned index;
 };
-
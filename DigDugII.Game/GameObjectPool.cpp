@@ -0,0 +1,299 @@
+#include "GameObjectPool.h"
+
+const GameObjectHandle GameObjectPool::NullHandle = {~0u, 0};
+
+// Objects only ever face one of the four grid directions, so their rotations are built once
+const glm::mat4 GameObjectPool::rotationMatrices[GameObjectPool::QuarterTurns] =
+{
+    glm::orientate4(glm::vec3(0.0, 0.0, glm::radians(0.0))),
+    glm::orientate4(glm::vec3(0.0, 0.0, glm::radians(90.0))),
+    glm::orientate4(glm::vec3(0.0, 0.0, glm::radians(180.0))),
+    glm::orientate4(glm::vec3(0.0, 0.0, glm::radians(270.0)))
+};
+
+// Moves the last element into the hole at index, keeping the array packed
+template<typename T>
+static void RemoveAt(std::vector<T> &values, unsigned index)
+{
+    values[index] = values.back();
+    values.pop_back();
+}
+
+GameObjectPool::GameObjectPool()
+{
+}
+
+GameObjectPool::~GameObjectPool()
+{
+}
+
+void GameObjectPool::Reserve(size_t capacity)
+{
+    positions.reserve(capacity);
+    previousPositions.reserve(capacity);
+    velocities.reserve(capacity);
+    states.reserve(capacity);
+    objectTypes.reserve(capacity);
+    orientations.reserve(capacity);
+    cells.reserve(capacity);
+    targets.reserve(capacity);
+    models.reserve(capacity);
+    rotations.reserve(capacity);
+    scales.reserve(capacity);
+    modelMatrices.reserve(capacity);
+    normalMatrices.reserve(capacity);
+    modelMatricesDirty.reserve(capacity);
+    dynamicIndices.reserve(capacity);
+    dynamics.reserve(capacity);
+    objects.reserve(capacity);
+    denseToSlot.reserve(capacity);
+    slots.reserve(capacity);
+}
+
+GameObjectHandle GameObjectPool::Create(Model *model, glm::vec3 position, GameObject::Object object, int positionX, int positionZ)
+{
+    unsigned index;
+    if(!freeSlots.empty())
+    {
+        index = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else
+    {
+        index = (unsigned)slots.size();
+        slots.push_back({FreeSlot, 0});
+    }
+
+    unsigned dense = (unsigned)objects.size();
+    slots[index].dense = dense;
+    denseToSlot.push_back(index);
+
+    positions.push_back(position);
+    previousPositions.push_back(position);
+    velocities.push_back(glm::vec3(0.0, 0.0, 0.0));
+    states.push_back(GameObject::INERT);
+    objectTypes.push_back(object);
+    orientations.push_back(GameObject::DOWN);
+    cells.push_back(glm::ivec2(positionX, positionZ));
+    targets.push_back(glm::ivec2(positionX, positionZ));
+    models.push_back(model);
+    rotations.push_back(0);
+    scales.push_back(glm::vec3(1.0, 1.0, 1.0));
+    modelMatrices.push_back(glm::mat4());
+    normalMatrices.push_back(glm::mat3());
+    modelMatricesDirty.push_back(true);
+    dynamicIndices.push_back((unsigned)dynamics.size());
+    dynamics.push_back(dense);
+    objects.emplace_back(this, dense);
+
+    return {index, slots[index].generation};
+}
+
+void GameObjectPool::Destroy(GameObjectHandle handle)
+{
+    if(Get(handle) == nullptr)
+    {
+        std::cerr << "GAME_OBJECT_POOL::DESTROY::STALE_HANDLE " << handle.index << std::endl;
+        return;
+    }
+
+    Slot &slot = slots[handle.index];
+    unsigned dense = slot.dense;
+    SetStatic(dense, true);
+
+    // Keep the live objects packed, the last one fills the hole in every array
+    RemoveAt(positions, dense);
+    RemoveAt(previousPositions, dense);
+    RemoveAt(velocities, dense);
+    RemoveAt(states, dense);
+    RemoveAt(objectTypes, dense);
+    RemoveAt(orientations, dense);
+    RemoveAt(cells, dense);
+    RemoveAt(targets, dense);
+    RemoveAt(models, dense);
+    RemoveAt(rotations, dense);
+    RemoveAt(scales, dense);
+    RemoveAt(modelMatrices, dense);
+    RemoveAt(normalMatrices, dense);
+    RemoveAt(modelMatricesDirty, dense);
+    RemoveAt(dynamicIndices, dense);
+    RemoveAt(denseToSlot, dense);
+    objects.pop_back();
+
+    if(dense < denseToSlot.size())
+    {
+        slots[denseToSlot[dense]].dense = dense;
+        if(dynamicIndices[dense] != StaticObject)
+        {
+            dynamics[dynamicIndices[dense]] = dense;
+        }
+    }
+
+    slot.dense = FreeSlot;
+    ++slot.generation;
+    freeSlots.push_back(handle.index);
+}
+
+void GameObjectPool::Clear()
+{
+    // Frees the whole level at once, every outstanding handle goes stale
+    positions.clear();
+    previousPositions.clear();
+    velocities.clear();
+    states.clear();
+    objectTypes.clear();
+    orientations.clear();
+    cells.clear();
+    targets.clear();
+    models.clear();
+    rotations.clear();
+    scales.clear();
+    modelMatrices.clear();
+    normalMatrices.clear();
+    modelMatricesDirty.clear();
+    dynamicIndices.clear();
+    dynamics.clear();
+    objects.clear();
+    denseToSlot.clear();
+    freeSlots.clear();
+    for(unsigned i = (unsigned)slots.size(); i-- > 0;)
+    {
+        if(slots[i].dense != FreeSlot)
+        {
+            slots[i].dense = FreeSlot;
+            ++slots[i].generation;
+        }
+        freeSlots.push_back(i);
+    }
+}
+
+void GameObjectPool::Update(float deltaTime)
+{
+    // Static objects are inert until SetStatic(false) makes them dynamic again, only the dynamic ones can move
+    for(unsigned dense : dynamics)
+    {
+        previousPositions[dense] = positions[dense];
+        bool moving = states[dense] != GameObject::INERT;
+        positions[dense] += velocities[dense] * (moving ? deltaTime : 0.0f);
+        modelMatricesDirty[dense] |= (unsigned char)moving;
+    }
+}
+
+void GameObjectPool::Draw(float alpha)
+{
+    // Queue an instance per dynamic object, each model issues the actual draw for all its instances at once
+    for(unsigned dense : dynamics)
+    {
+        // Interpolation only moves the object, the normal matrix is the same for both
+        if(previousPositions[dense] == positions[dense])
+        {
+            models[dense]->AddInstance(GetModelMatrix(dense), GetNormalMatrix(dense));
+        }
+        else
+        {
+            models[dense]->AddInstance(objects[dense].GetModelMatrix(alpha), GetNormalMatrix(dense));
+        }
+    }
+}
+
+GameObject * GameObjectPool::Get(GameObjectHandle handle)
+{
+    if(handle.index >= slots.size())
+    {
+        return nullptr;
+    }
+
+    const Slot &slot = slots[handle.index];
+    if(slot.dense == FreeSlot || slot.generation != handle.generation)
+    {
+        return nullptr;
+    }
+
+    return &objects[slot.dense];
+}
+
+GameObjectHandle GameObjectPool::GetHandle(const GameObject *gameObject)
+{
+    if(gameObject == nullptr)
+    {
+        return NullHandle;
+    }
+
+    unsigned index = denseToSlot[gameObject - objects.data()];
+    return {index, slots[index].generation};
+}
+
+size_t GameObjectPool::GetCount()
+{
+    return objects.size();
+}
+
+std::vector<GameObject>::iterator GameObjectPool::begin()
+{
+    return objects.begin();
+}
+
+std::vector<GameObject>::iterator GameObjectPool::end()
+{
+    return objects.end();
+}
+
+const glm::mat4& GameObjectPool::GetModelMatrix(unsigned dense)
+{
+    // Translation * rotation * scale, rebuilt only after the object moved, turned or was scaled
+    if(modelMatricesDirty[dense])
+    {
+        glm::mat4 &modelMatrix = modelMatrices[dense];
+        modelMatrix = rotationMatrices[rotations[dense]];
+        modelMatrix[0] *= scales[dense].x;
+        modelMatrix[1] *= scales[dense].y;
+        modelMatrix[2] *= scales[dense].z;
+        modelMatrix[3] = glm::vec4(positions[dense], 1.0);
+
+        // Inverse transpose of rotation * scale is rotation * inverse scale, so the shader needs no inverse
+        glm::mat3 &normalMatrix = normalMatrices[dense];
+        normalMatrix = glm::mat3(modelMatrix);
+        normalMatrix[0] /= scales[dense].x * scales[dense].x;
+        normalMatrix[1] /= scales[dense].y * scales[dense].y;
+        normalMatrix[2] /= scales[dense].z * scales[dense].z;
+        modelMatricesDirty[dense] = false;
+    }
+
+    return modelMatrices[dense];
+}
+
+const glm::mat3& GameObjectPool::GetNormalMatrix(unsigned dense)
+{
+    GetModelMatrix(dense);
+    return normalMatrices[dense];
+}
+
+void GameObjectPool::SetStatic(unsigned dense, bool isStatic)
+{
+    unsigned index = dynamicIndices[dense];
+    if(isStatic && index != StaticObject)
+    {
+        // The last dynamic object takes its place in the list
+        dynamics[index] = dynamics.back();
+        dynamicIndices[dynamics[index]] = index;
+        dynamics.pop_back();
+        dynamicIndices[dense] = StaticObject;
+    }
+    else if(!isStatic && index == StaticObject)
+    {
+        // Static objects skip the per-tick snapshot, start interpolating from where the object is now
+        previousPositions[dense] = positions[dense];
+        dynamicIndices[dense] = (unsigned)dynamics.size();
+        dynamics.push_back(dense);
+    }
+}
+
+bool operator==(const GameObjectHandle &a, const GameObjectHandle &b)
+{
+    return a.index == b.index && a.generation == b.generation;
+}
+
+bool operator!=(const GameObjectHandle &a, const GameObjectHandle &b)
+{
+    return !(a == b);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vector>
+#include "GameObject.h"
+
+// Reference to a pooled GameObject. The generation changes every time its slot is freed, so a
+// handle kept past the object's destruction or a level reload resolves to nullptr instead of
+// pointing at whatever reused the memory.
+struct GameObjectHandle
+{
+    unsigned index;
+    unsigned generation;
+};
+
+// Contiguous store for the GameObjects of a level, kept as one array per component so the
+// per-tick loops only stream through the data they use. Live objects are packed at the front,
+// destroying one moves the last object into its place, so pointers returned by Get are only
+// valid until the next Destroy or Clear. The dynamic objects are also listed by index, so the
+// per-tick and per-frame loops skip the static blocks baked into the level mesh.
+class GameObjectPool
+{
+    friend class GameObject;
+
+public:
+    static const GameObjectHandle NullHandle;
+
+    GameObjectPool();
+    ~GameObjectPool();
+
+    void Reserve(size_t capacity);
+    GameObjectHandle Create(Model *model, glm::vec3 position, GameObject::Object object, int positionX, int positionZ);
+    void Destroy(GameObjectHandle handle);
+    void Clear();
+
+    void Update(float deltaTime);
+    void Draw(float alpha);
+
+    GameObject* Get(GameObjectHandle handle);
+    GameObjectHandle GetHandle(const GameObject *gameObject);
+    size_t GetCount();
+
+    std::vector<GameObject>::iterator begin();
+    std::vector<GameObject>::iterator end();
+
+private:
+    static const unsigned FreeSlot = ~0u;
+    static const unsigned StaticObject = ~0u;
+    static const int QuarterTurns = 4;
+    static const glm::mat4 rotationMatrices[QuarterTurns];
+
+    struct Slot
+    {
+        unsigned dense;
+        unsigned generation;
+    };
+
+    // Simulation components
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> previousPositions;
+    std::vector<glm::vec3> velocities;
+    std::vector<GameObject::State> states;
+    std::vector<GameObject::Object> objectTypes;
+    std::vector<GameObject::Orientation> orientations;
+    std::vector<glm::ivec2> cells;
+    std::vector<glm::ivec2> targets;
+
+    // Render components
+    std::vector<Model*> models;
+    std::vector<unsigned char> rotations;
+    std::vector<glm::vec3> scales;
+    std::vector<glm::mat4> modelMatrices;
+    std::vector<glm::mat3> normalMatrices;
+    std::vector<unsigned char> modelMatricesDirty;
+    // Position of each object in dynamics, StaticObject for the baked ones
+    std::vector<unsigned> dynamicIndices;
+
+    // Dense indices of the objects that are not static, in no particular order
+    std::vector<unsigned> dynamics;
+
+    std::vector<GameObject> objects;
+    std::vector<unsigned> denseToSlot;
+    std::vector<Slot> slots;
+    std::vector<unsigned> freeSlots;
+
+    const glm::mat4& GetModelMatrix(unsigned dense);
+    const glm::mat3& GetNormalMatrix(unsigned dense);
+    void SetStatic(unsigned dense, bool isStatic);
+};
+
+bool operator==(const GameObjectHandle &a, const GameObjectHandle &b);
+bool operator!=(const GameObjectHandle &a, const GameObjectHandle &b);
@@ -0,0 +1,636 @@
+#include "LevelMesh.h"
+
+LevelMesh::LevelMesh()
+    : width(0),
+    height(0),
+    chunksX(0),
+    chunksZ(0),
+    bakeObjects(nullptr)
+{
+}
+
+LevelMesh::~LevelMesh()
+{
+}
+
+void LevelMesh::Resize(int levelWidth, int levelHeight)
+{
+    width = levelWidth;
+    height = levelHeight;
+    chunksX = (levelWidth + ChunkSize - 1) / ChunkSize;
+    chunksZ = (levelHeight + ChunkSize - 1) / ChunkSize;
+
+    chunks.clear();
+    chunks.resize(chunksX * chunksZ);
+    dirtyChunks.clear();
+    for(int i = 0; i < (int)chunks.size(); ++i)
+    {
+        chunks[i].dirty = true;
+        dirtyChunks.push_back(i);
+    }
+}
+
+void LevelMesh::MarkDirty(int x, int z)
+{
+    // A tile also hides faces of its four neighbours, and those can sit in the next chunk
+    static const int offsets[5][2] = {{0, 0}, {0, 1}, {0, -1}, {1, 0}, {-1, 0}};
+
+    for(const int *offset : offsets)
+    {
+        int nx = x + offset[0];
+        int nz = z + offset[1];
+        if(nx < 0 || nx >= width || nz < 0 || nz >= height)
+        {
+            continue;
+        }
+
+        int chunk = (nz / ChunkSize) * chunksX + nx / ChunkSize;
+        if(!chunks[chunk].dirty)
+        {
+            chunks[chunk].dirty = true;
+            dirtyChunks.push_back(chunk);
+        }
+    }
+}
+
+std::vector<int>& LevelMesh::GetDirtyChunks()
+{
+    return dirtyChunks;
+}
+
+void LevelMesh::GetChunkTiles(int chunk, int *startX, int *startZ, int *endX, int *endZ)
+{
+    *startX = (chunk % chunksX) * ChunkSize;
+    *startZ = (chunk / chunksX) * ChunkSize;
+    *endX = *startX + ChunkSize;
+    *endZ = *startZ + ChunkSize;
+}
+
+void LevelMesh::Bake(int chunk, const std::vector<GameObject*> &objects, Shader *shader)
+{
+    size_t bufferCount = 0;
+    bakeObjects = &objects;
+    for(BakeBuffer &buffer : bakeBuffers)
+    {
+        buffer.vertices.clear();
+        buffer.indices.clear();
+    }
+
+    quadKeys.clear();
+    for(int layer = 0; layer < Layers; ++layer)
+    {
+        for(int direction = 0; direction < Directions; ++direction)
+        {
+            faceMasks[layer][direction].assign(ChunkSize * ChunkSize, -1);
+        }
+    }
+
+    // Collect the exposed faces of every block, meshes that are not boxes go in whole
+    for(int layer = 0; layer < Layers; ++layer)
+    {
+        for(int z = 0; z < ChunkSize; ++z)
+        {
+            for(int x = 0; x < ChunkSize; ++x)
+            {
+                GameObject *object = GetBakeObject(layer, x, z);
+                if(object == nullptr)
+                {
+                    continue;
+                }
+
+                for(Mesh &mesh : object->GetModel()->GetMeshes())
+                {
+                    size_t buffer = GetBakeBuffer(mesh, &bufferCount);
+                    BoxFaces &box = GetBoxFaces(mesh);
+                    if(!box.isBox)
+                    {
+                        BakeTriangles(mesh, object, bakeBuffers[buffer]);
+                        continue;
+                    }
+
+                    for(const Face &face : box.faces)
+                    {
+                        AddFace(face, object, buffer, layer, x, z);
+                    }
+                }
+            }
+        }
+    }
+
+    for(int layer = 0; layer < Layers; ++layer)
+    {
+        for(int direction = 0; direction < Directions; ++direction)
+        {
+            MergeFaces(layer, direction);
+        }
+    }
+
+    // Reuse the chunk's buffers for materials it already had, materials no longer present are emptied
+    std::vector<Batch> &batches = chunks[chunk].batches;
+    for(Batch &batch : batches)
+    {
+        bool found = false;
+        for(size_t i = 0; i < bufferCount && !found; ++i)
+        {
+            found = bakeBuffers[i].material == batch.material;
+        }
+
+        if(!found && batch.mesh.GetIndexCount() > 0)
+        {
+            batch.mesh.SetData(std::vector<Vertex>(), std::vector<unsigned int>());
+        }
+    }
+
+    for(size_t i = 0; i < bufferCount; ++i)
+    {
+        BakeBuffer &buffer = bakeBuffers[i];
+        Batch *target = nullptr;
+        for(Batch &batch : batches)
+        {
+            if(batch.material == buffer.material)
+            {
+                target = &batch;
+                break;
+            }
+        }
+
+        if(target != nullptr)
+        {
+            target->mesh.SetData(buffer.vertices, buffer.indices);
+        }
+        else if(!buffer.indices.empty())
+        {
+            // The bake buffers are kept for the next bake, the mesh uploads from them without a copy of its own
+            batches.push_back({buffer.material, Mesh(std::vector<Vertex>(), std::vector<unsigned int>(), buffer.textures)});
+            batches.back().mesh.SetWorldSpace(true);
+            batches.back().mesh.Upload();
+            batches.back().mesh.SetData(buffer.vertices, buffer.indices);
+            batches.back().mesh.LoadUniforms(shader);
+        }
+    }
+
+    chunks[chunk].dirty = false;
+    bakeObjects = nullptr;
+}
+
+void LevelMesh::ClearDirtyChunks()
+{
+    dirtyChunks.clear();
+}
+
+void LevelMesh::Queue(RenderQueue &queue, Shader *shader, glm::vec3 eye)
+{
+    // Baked vertices are already in world space, the model and normal matrix attributes fall back to identity.
+    // It is current vertex state rather than part of a draw, so it holds for the whole pass
+    glm::mat4 identity;
+    for(int i = 0; i < 4; ++i)
+    {
+        glVertexAttrib4fv(Shader::ModelAttributeIndex + i, glm::value_ptr(identity[i]));
+    }
+    for(int i = 0; i < 3; ++i)
+    {
+        glVertexAttrib3fv(Shader::NormalMatrixAttributeIndex + i, glm::value_ptr(identity[i]));
+    }
+
+    for(size_t i = 0; i < chunks.size(); ++i)
+    {
+        // Tiles are two units apart, the chunk centre is the middle of its tile span
+        float centerX = (float)(((int)i % chunksX) * ChunkSize * 2 + ChunkSize - 1);
+        float centerZ = (float)(((int)i / chunksX) * ChunkSize * 2 + ChunkSize - 1);
+        float depth = glm::length(glm::vec3(centerX, 0.0f, centerZ) - eye);
+        for(Batch &batch : chunks[i].batches)
+        {
+            queue.Add(&batch.mesh, shader, 0, depth);
+        }
+    }
+}
+
+size_t LevelMesh::GetCpuBytes()
+{
+    size_t bytes = 0;
+    for(const BakeBuffer &buffer : bakeBuffers)
+    {
+        bytes += buffer.vertices.capacity() * sizeof(Vertex) + buffer.indices.capacity() * sizeof(unsigned int);
+    }
+
+    return bytes;
+}
+
+size_t LevelMesh::GetGpuBytes()
+{
+    size_t bytes = 0;
+    for(Chunk &chunk : chunks)
+    {
+        for(Batch &batch : chunk.batches)
+        {
+            bytes += batch.mesh.GetGpuBytes();
+        }
+    }
+
+    return bytes;
+}
+
+size_t LevelMesh::GetBakeBuffer(Mesh &mesh, size_t *bufferCount)
+{
+    // TextureCache gives every file one GL texture, so equal names mean equal textures. Texture array blocks
+    // have none and all share one buffer, their layer travels with the vertices
+    materialKey.clear();
+    for(Texture &texture : mesh.GetTextures())
+    {
+        materialKey.push_back(texture.id);
+    }
+
+    for(size_t i = 0; i < *bufferCount; ++i)
+    {
+        if(bakeBuffers[i].material == materialKey)
+        {
+            return i;
+        }
+    }
+
+    if(*bufferCount == bakeBuffers.size())
+    {
+        bakeBuffers.push_back(BakeBuffer());
+    }
+
+    BakeBuffer &buffer = bakeBuffers[*bufferCount];
+    buffer.material = materialKey;
+    buffer.textures = mesh.GetTextures();
+    return (*bufferCount)++;
+}
+
+LevelMesh::BoxFaces& LevelMesh::GetBoxFaces(Mesh &mesh)
+{
+    std::unordered_map<Mesh*, BoxFaces>::iterator cached = boxFaces.find(&mesh);
+    if(cached != boxFaces.end())
+    {
+        return cached->second;
+    }
+
+    BoxFaces &box = boxFaces[&mesh];
+    box.isBox = true;
+
+    std::vector<Vertex> &vertices = mesh.GetVertices();
+    std::vector<unsigned int> &indices = mesh.GetIndices();
+    std::vector<unsigned int> sides[Directions];
+    float areas[Directions] = {};
+    glm::vec3 minimums[Directions];
+    glm::vec3 maximums[Directions];
+
+    // Sort the triangles by the axis they face, a box side is flat and covers its whole rectangle
+    for(size_t i = 0; i + 2 < indices.size() && box.isBox; i += 3)
+    {
+        glm::vec3 normal = vertices[indices[i]].normal;
+        glm::vec3 magnitude = glm::abs(normal);
+        if(std::max(magnitude.x, std::max(magnitude.y, magnitude.z)) < 0.99f)
+        {
+            box.isBox = false;
+            break;
+        }
+
+        int direction = GetDirection(normal);
+        glm::vec3 a = vertices[indices[i]].position;
+        glm::vec3 b = vertices[indices[i + 1]].position;
+        glm::vec3 c = vertices[indices[i + 2]].position;
+        if(sides[direction].empty())
+        {
+            minimums[direction] = a;
+            maximums[direction] = a;
+        }
+
+        for(int j = 0; j < 3; ++j)
+        {
+            sides[direction].push_back(indices[i + j]);
+            minimums[direction] = glm::min(minimums[direction], vertices[indices[i + j]].position);
+            maximums[direction] = glm::max(maximums[direction], vertices[indices[i + j]].position);
+        }
+        areas[direction] += 0.5f * glm::length(glm::cross(b - a, c - a));
+    }
+
+    for(int direction = 0; direction < Directions && box.isBox; ++direction)
+    {
+        if(sides[direction].empty())
+        {
+            continue;
+        }
+
+        int axisA;
+        int axisB;
+        int axisNormal = direction / 2;
+        GetPlaneAxes(direction, &axisA, &axisB);
+
+        glm::vec3 minimum = minimums[direction];
+        glm::vec3 maximum = maximums[direction];
+        float rectangle = (maximum[axisA] - minimum[axisA]) * (maximum[axisB] - minimum[axisB]);
+        if(maximum[axisNormal] - minimum[axisNormal] > 0.001f || std::abs(areas[direction] - rectangle) > 0.001f * rectangle)
+        {
+            box.isBox = false;
+            break;
+        }
+
+        // Blocks from the texture array share a material, the layer has to be the same across a side
+        for(unsigned int index : sides[direction])
+        {
+            box.isBox = box.isBox && vertices[index].layer == vertices[sides[direction][0]].layer;
+        }
+
+        Face face;
+        face.layer = vertices[sides[direction][0]].layer;
+        face.normal = glm::vec3(0.0f);
+        face.normal[axisNormal] = direction % 2 == 0 ? 1.0f : -1.0f;
+
+        for(int corner = 0; corner < 4 && box.isBox; ++corner)
+        {
+            glm::vec3 position = minimum;
+            position[axisA] = (corner == 1 || corner == 2) ? maximum[axisA] : minimum[axisA];
+            position[axisB] = (corner >= 2) ? maximum[axisB] : minimum[axisB];
+            face.corners[corner] = position;
+
+            bool found = false;
+            for(unsigned int index : sides[direction])
+            {
+                glm::vec3 offset = glm::abs(vertices[index].position - position);
+                if(offset[axisA] < 0.001f && offset[axisB] < 0.001f)
+                {
+                    // Models inset their coordinates from the texture edge, snap them so merged faces tile exactly
+                    glm::vec2 texCoords = vertices[index].texCoords;
+                    glm::vec2 rounded = glm::round(texCoords);
+                    face.texCoords[corner] = glm::mix(texCoords, rounded, glm::lessThan(glm::abs(texCoords - rounded), glm::vec2(0.001f)));
+                    found = true;
+                    break;
+                }
+            }
+            box.isBox = found;
+        }
+
+        box.faces.push_back(face);
+    }
+
+    if(!box.isBox)
+    {
+        box.faces.clear();
+    }
+
+    return box;
+}
+
+void LevelMesh::AddFace(const Face &face, GameObject *object, size_t buffer, int layer, int x, int z)
+{
+    const glm::mat4 &modelMatrix = object->GetModelMatrix();
+    int direction = GetDirection(glm::mat3(modelMatrix) * face.normal);
+    int axisNormal = direction / 2;
+    int sign = direction % 2 == 0 ? 1 : -1;
+
+    // A side touching another block of its layer, or a top under a block of the layer above, is never seen
+    if(axisNormal == 1)
+    {
+        int otherLayer = layer + sign;
+        if(otherLayer >= 0 && otherLayer < Layers && GetBakeObject(otherLayer, x, z) != nullptr)
+        {
+            return;
+        }
+    }
+    else if(GetBakeObject(layer, x + (axisNormal == 0 ? sign : 0), z + (axisNormal == 2 ? sign : 0)) != nullptr)
+    {
+        return;
+    }
+
+    int axisA;
+    int axisB;
+    GetPlaneAxes(direction, &axisA, &axisB);
+
+    glm::vec3 corners[4];
+    glm::vec3 minimum;
+    glm::vec3 maximum;
+    for(int i = 0; i < 4; ++i)
+    {
+        corners[i] = glm::vec3(modelMatrix * glm::vec4(face.corners[i], 1.0f));
+        minimum = i == 0 ? corners[i] : glm::min(minimum, corners[i]);
+        maximum = i == 0 ? corners[i] : glm::max(maximum, corners[i]);
+    }
+
+    // Texture coordinates as an affine function of the position in the face's plane
+    glm::vec2 texCoordsMinimum;
+    glm::vec2 texCoordsA;
+    glm::vec2 texCoordsB;
+    for(int i = 0; i < 4; ++i)
+    {
+        bool atMinimumA = std::abs(corners[i][axisA] - minimum[axisA]) < 0.001f;
+        bool atMinimumB = std::abs(corners[i][axisB] - minimum[axisB]) < 0.001f;
+        if(atMinimumA && atMinimumB)
+        {
+            texCoordsMinimum = face.texCoords[i];
+        }
+        else if(!atMinimumA && atMinimumB)
+        {
+            texCoordsA = face.texCoords[i];
+        }
+        else if(atMinimumA && !atMinimumB)
+        {
+            texCoordsB = face.texCoords[i];
+        }
+    }
+
+    QuadKey key;
+    key.buffer = buffer;
+    key.direction = direction;
+    key.layer = face.layer;
+    key.texCoordsPerUnit[0] = (texCoordsA - texCoordsMinimum) / (maximum[axisA] - minimum[axisA]);
+    key.texCoordsPerUnit[1] = (texCoordsB - texCoordsMinimum) / (maximum[axisB] - minimum[axisB]);
+    key.texCoordsOrigin = texCoordsMinimum - key.texCoordsPerUnit * glm::vec2(minimum[axisA], minimum[axisB]);
+
+    // Extent relative to the block, so faces of neighbouring blocks compare equal
+    glm::vec3 position = object->GetPosition();
+    key.minimum = minimum - glm::vec3(position.x, 0.0f, position.z);
+    key.maximum = maximum - glm::vec3(position.x, 0.0f, position.z);
+
+    int &mask = faceMasks[layer][direction][z * ChunkSize + x];
+    if(mask != -1)
+    {
+        // Two meshes of one block facing the same way, keep the second one as its own quad
+        AddQuad(key, minimum, maximum);
+        return;
+    }
+
+    for(size_t i = 0; i < quadKeys.size(); ++i)
+    {
+        if(IsSameKey(quadKeys[i], key))
+        {
+            mask = (int)i;
+            return;
+        }
+    }
+
+    mask = (int)quadKeys.size();
+    quadKeys.push_back(key);
+}
+
+void LevelMesh::MergeFaces(int layer, int direction)
+{
+    // Greedy meshing: grow each face along x, then along z, as far as the same key continues.
+    // Sides only merge within their own plane, so x sides grow along z and z sides along x
+    std::vector<int> &mask = faceMasks[layer][direction];
+    int axisNormal = direction / 2;
+    bool mergeX = axisNormal != 0;
+    bool mergeZ = axisNormal != 2;
+
+    for(int z = 0; z < ChunkSize; ++z)
+    {
+        for(int x = 0; x < ChunkSize; ++x)
+        {
+            int key = mask[z * ChunkSize + x];
+            if(key == -1)
+            {
+                continue;
+            }
+
+            int sizeX = 1;
+            while(mergeX && x + sizeX < ChunkSize && mask[z * ChunkSize + x + sizeX] == key)
+            {
+                ++sizeX;
+            }
+
+            int sizeZ = 1;
+            bool rowMatches = mergeZ;
+            while(rowMatches && z + sizeZ < ChunkSize)
+            {
+                for(int i = 0; i < sizeX && rowMatches; ++i)
+                {
+                    rowMatches = mask[(z + sizeZ) * ChunkSize + x + i] == key;
+                }
+
+                if(rowMatches)
+                {
+                    ++sizeZ;
+                }
+            }
+
+            for(int j = 0; j < sizeZ; ++j)
+            {
+                for(int i = 0; i < sizeX; ++i)
+                {
+                    mask[(z + j) * ChunkSize + x + i] = -1;
+                }
+            }
+
+            glm::vec3 first = GetBakeObject(layer, x, z)->GetPosition();
+            glm::vec3 last = GetBakeObject(layer, x + sizeX - 1, z + sizeZ - 1)->GetPosition();
+            const QuadKey &quadKey = quadKeys[key];
+            AddQuad(quadKey,
+                    quadKey.minimum + glm::vec3(first.x, 0.0f, first.z),
+                    quadKey.maximum + glm::vec3(last.x, 0.0f, last.z));
+        }
+    }
+}
+
+void LevelMesh::AddQuad(const QuadKey &key, glm::vec3 minimum, glm::vec3 maximum)
+{
+    BakeBuffer &buffer = bakeBuffers[key.buffer];
+    int axisA;
+    int axisB;
+    int axisNormal = key.direction / 2;
+    GetPlaneAxes(key.direction, &axisA, &axisB);
+
+    glm::vec3 normal(0.0f);
+    normal[axisNormal] = key.direction % 2 == 0 ? 1.0f : -1.0f;
+
+    glm::vec3 corners[4];
+    for(int i = 0; i < 4; ++i)
+    {
+        corners[i] = minimum;
+        corners[i][axisA] = (i == 1 || i == 2) ? maximum[axisA] : minimum[axisA];
+        corners[i][axisB] = (i >= 2) ? maximum[axisB] : minimum[axisB];
+    }
+
+    // Textures repeat, so dropping whole units keeps coordinates small on big levels
+    glm::vec2 texCoordsShift = glm::floor(key.texCoordsOrigin + key.texCoordsPerUnit * glm::vec2(minimum[axisA], minimum[axisB]));
+    unsigned int baseVertex = (unsigned int)buffer.vertices.size();
+    for(int i = 0; i < 4; ++i)
+    {
+        Vertex vertex;
+        vertex.position = corners[i];
+        vertex.normal = normal;
+        vertex.layer = key.layer;
+        vertex.texCoords = key.texCoordsOrigin + key.texCoordsPerUnit * glm::vec2(corners[i][axisA], corners[i][axisB]) - texCoordsShift;
+        buffer.vertices.push_back(vertex);
+    }
+
+    // Counter-clockwise seen from the side the quad faces
+    bool frontFacing = glm::dot(glm::cross(corners[1] - corners[0], corners[3] - corners[0]), normal) > 0.0f;
+    static const unsigned int front[6] = {0, 1, 2, 0, 2, 3};
+    static const unsigned int back[6] = {0, 2, 1, 0, 3, 2};
+    for(int i = 0; i < 6; ++i)
+    {
+        buffer.indices.push_back(baseVertex + (frontFacing ? front[i] : back[i]));
+    }
+}
+
+void LevelMesh::BakeTriangles(Mesh &mesh, GameObject *object, BakeBuffer &buffer)
+{
+    const glm::mat4 &modelMatrix = object->GetModelMatrix();
+    const glm::mat3 &normalMatrix = object->GetNormalMatrix();
+    unsigned int baseVertex = (unsigned int)buffer.vertices.size();
+
+    for(const Vertex &vertex : mesh.GetVertices())
+    {
+        Vertex baked;
+        baked.position = glm::vec3(modelMatrix * glm::vec4(vertex.position, 1.0f));
+        baked.normal = glm::normalize(normalMatrix * vertex.normal);
+        baked.texCoords = vertex.texCoords;
+        baked.layer = vertex.layer;
+        buffer.vertices.push_back(baked);
+    }
+
+    for(unsigned int index : mesh.GetIndices())
+    {
+        buffer.indices.push_back(baseVertex + index);
+    }
+}
+
+GameObject * LevelMesh::GetBakeObject(int layer, int x, int z)
+{
+    return (*bakeObjects)[(layer * BakeGridSize + z + 1) * BakeGridSize + x + 1];
+}
+
+bool LevelMesh::IsSameKey(const QuadKey &a, const QuadKey &b)
+{
+    if(a.buffer != b.buffer || a.direction != b.direction || a.layer != b.layer)
+    {
+        return false;
+    }
+
+    glm::bvec3 sameMinimum = glm::lessThan(glm::abs(a.minimum - b.minimum), glm::vec3(0.001f));
+    glm::bvec3 sameMaximum = glm::lessThan(glm::abs(a.maximum - b.maximum), glm::vec3(0.001f));
+    glm::bvec2 sameA = glm::lessThan(glm::abs(a.texCoordsPerUnit[0] - b.texCoordsPerUnit[0]), glm::vec2(0.001f));
+    glm::bvec2 sameB = glm::lessThan(glm::abs(a.texCoordsPerUnit[1] - b.texCoordsPerUnit[1]), glm::vec2(0.001f));
+
+    // The origins may differ by whole texture repeats
+    glm::vec2 origin = a.texCoordsOrigin - b.texCoordsOrigin;
+    glm::bvec2 sameOrigin = glm::lessThan(glm::abs(origin - glm::round(origin)), glm::vec2(0.001f));
+
+    return glm::all(sameMinimum) && glm::all(sameMaximum) && glm::all(sameA) && glm::all(sameB) && glm::all(sameOrigin);
+}
+
+int LevelMesh::GetDirection(glm::vec3 normal)
+{
+    // 0 and 1 face +x and -x, 2 and 3 face +y and -y, 4 and 5 face +z and -z
+    glm::vec3 magnitude = glm::abs(normal);
+    int axis = 0;
+    if(magnitude.y > magnitude[axis])
+    {
+        axis = 1;
+    }
+    if(magnitude.z > magnitude[axis])
+    {
+        axis = 2;
+    }
+
+    return axis * 2 + (normal[axis] < 0.0f ? 1 : 0);
+}
+
+void LevelMesh::GetPlaneAxes(int direction, int *axisA, int *axisB)
+{
+    int axisNormal = direction / 2;
+    *axisA = axisNormal == 0 ? 1 : 0;
+    *axisB = axisNormal == 2 ? 1 : 2;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include "Shader.h"
+#include "Mesh.h"
+#include "GameObject.h"
+#include "RenderQueue.h"
+
+// Static blocks of the level baked into one vertex buffer per chunk and material, so the ground costs
+// a handful of draws instead of an instance per block. Faces hidden by a neighbouring block are left
+// out and the remaining ones are merged into larger quads. A chunk is only rebaked after one of its
+// tiles changed, blocks that start sinking leave the bake and go back to the instanced path.
+class LevelMesh
+{
+public:
+    static const int ChunkSize = 16;
+    // Bake input covers a chunk plus a one tile border, the border is only used to hide faces
+    static const int BakeGridSize = ChunkSize + 2;
+
+    LevelMesh();
+    ~LevelMesh();
+
+    void Resize(int levelWidth, int levelHeight);
+    void MarkDirty(int x, int z);
+    std::vector<int>& GetDirtyChunks();
+    void GetChunkTiles(int chunk, int *startX, int *startZ, int *endX, int *endZ);
+    void Bake(int chunk, const std::vector<GameObject*> &objects, Shader *shader);
+    void ClearDirtyChunks();
+    void Queue(RenderQueue &queue, Shader *shader, glm::vec3 eye);
+    // CPU bytes are the bake buffers kept between bakes, GPU bytes the baked chunk buffers
+    size_t GetCpuBytes();
+    size_t GetGpuBytes();
+
+private:
+    static const int Layers = 2;
+    static const int Directions = 6;
+
+    // A material is the GL names of the mesh's textures, empty for blocks that sample the texture array
+    struct Batch
+    {
+        std::vector<unsigned int> material;
+        Mesh mesh;
+    };
+
+    struct Chunk
+    {
+        std::vector<Batch> batches;
+        bool dirty;
+    };
+
+    // Merged geometry of one material while a chunk is baked, kept between bakes to reuse the memory
+    struct BakeBuffer
+    {
+        std::vector<unsigned int> material;
+        std::vector<Texture> textures;
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+    };
+
+    // One side of a block mesh reduced to a single quad, corners in model space
+    struct Face
+    {
+        glm::vec3 normal;
+        glm::vec3 corners[4];
+        glm::vec2 texCoords[4];
+        float layer;
+    };
+
+    // Sides of a block mesh, a mesh that is not a plain box keeps isBox false and is baked triangle by triangle
+    struct BoxFaces
+    {
+        bool isBox;
+        std::vector<Face> faces;
+    };
+
+    // Exposed faces that share a key lie in the same plane and continue each other's texture, so they merge
+    struct QuadKey
+    {
+        size_t buffer;
+        int direction;
+        glm::vec3 minimum;
+        glm::vec3 maximum;
+        glm::mat2 texCoordsPerUnit;
+        glm::vec2 texCoordsOrigin;
+        float layer;
+    };
+
+    int width;
+    int height;
+    int chunksX;
+    int chunksZ;
+    std::vector<Chunk> chunks;
+    std::vector<int> dirtyChunks;
+    std::vector<BakeBuffer> bakeBuffers;
+    std::vector<unsigned int> materialKey;
+    std::unordered_map<Mesh*, BoxFaces> boxFaces;
+    const std::vector<GameObject*> *bakeObjects;
+    std::vector<QuadKey> quadKeys;
+    std::vector<int> faceMasks[Layers][Directions];
+
+    size_t GetBakeBuffer(Mesh &mesh, size_t *bufferCount);
+    BoxFaces& GetBoxFaces(Mesh &mesh);
+    void AddFace(const Face &face, GameObject *object, size_t buffer, int layer, int x, int z);
+    void MergeFaces(int layer, int direction);
+    void AddQuad(const QuadKey &key, glm::vec3 minimum, glm::vec3 maximum);
+    void BakeTriangles(Mesh &mesh, GameObject *object, BakeBuffer &buffer);
+    GameObject* GetBakeObject(int layer, int x, int z);
+    static bool IsSameKey(const QuadKey &a, const QuadKey &b);
+    static int GetDirection(glm::vec3 normal);
+    static void GetPlaneAxes(int direction, int *axisA, int *axisB);
+};
@@ -0,0 +1,132 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile()
+    : data(nullptr),
+    size(0),
+    file(INVALID_HANDLE_VALUE),
+    mapping(nullptr)
+{
+}
+#else
+MappedFile::MappedFile()
+    : data(nullptr),
+    size(0),
+    file(-1)
+{
+}
+#endif
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const std::string &path)
+{
+    Close();
+
+#ifdef _WIN32
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        Close();
+        return false;
+    }
+
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(mapping == nullptr)
+    {
+        Close();
+        return false;
+    }
+
+    data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    size = (size_t)fileSize.QuadPart;
+#else
+    file = open(path.c_str(), O_RDONLY);
+    if(file == -1)
+    {
+        return false;
+    }
+
+    struct stat status;
+    if(fstat(file, &status) != 0 || status.st_size == 0)
+    {
+        Close();
+        return false;
+    }
+
+    void *view = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    data = view == MAP_FAILED ? nullptr : (const unsigned char*)view;
+    size = (size_t)status.st_size;
+#endif
+
+    if(data == nullptr)
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+    if(data != nullptr)
+    {
+        UnmapViewOfFile(data);
+    }
+    if(mapping != nullptr)
+    {
+        CloseHandle(mapping);
+    }
+    if(file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(file);
+    }
+    mapping = nullptr;
+    file = INVALID_HANDLE_VALUE;
+#else
+    if(data != nullptr)
+    {
+        munmap((void*)data, size);
+    }
+    if(file != -1)
+    {
+        close(file);
+    }
+    file = -1;
+#endif
+
+    data = nullptr;
+    size = 0;
+}
+
+const unsigned char* MappedFile::GetData()
+{
+    return data;
+}
+
+size_t MappedFile::GetSize()
+{
+    return size;
+}
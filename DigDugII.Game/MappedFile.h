@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+// Read-only view of a whole file through the OS memory mapping, pages are only read once touched
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string &path);
+    void Close();
+
+    const unsigned char* GetData();
+    size_t GetSize();
+
+private:
+    const unsigned char *data;
+    size_t size;
+#ifdef _WIN32
+    void *file;
+    void *mapping;
+#else
+    int file;
+#endif
+};
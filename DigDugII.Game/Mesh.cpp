@@ -1,81 +1,349 @@
 #include "Mesh.h"
 
+std::vector<PackedVertex> Mesh::packedScratch;
+std::vector<WorldVertex> Mesh::worldScratch;
+std::vector<glm::uint16> Mesh::indexScratch;
+
 Mesh::Mesh(std::vector<Vertex> vertices,
            std::vector<unsigned int> indices,
            std::vector<Texture> textures)
-    : shininess(16.0f)
+    : VAO(0),
+    VBO(0),
+    EBO(0),
+    indexType(GL_UNSIGNED_INT),
+    indexCount(0),
+    gpuBytes(0),
+    keepData(false),
+    worldSpace(false),
+    shininess(16.0f),
+    shininessLocation(-1)
 {
-    this->vertices = vertices;
-    this->indices = indices;
-    this->textures = textures;
+    this->vertices = std::move(vertices);
+    this->indices = std::move(indices);
+    this->textures = std::move(textures);
 
+    // Sampler uniform names only depend on the texture types, build them once here instead of on every draw
+    unsigned int diffuseCount = 1;
+    unsigned int specularCount = 1;
+    for(const Texture &texture : this->textures)
+    {
+        std::stringstream ss;
+        if(texture.type == "texture_diffuse")
+        {
+            ss << diffuseCount++;
+        }
+        else if(texture.type == "texture_specular")
+        {
+            ss << specularCount++;
+        }
+
+        samplerNames.push_back("material." + texture.type + ss.str());
+    }
+}
+
+Mesh::Mesh(Mesh &&other) noexcept
+    : vertices(std::move(other.vertices)),
+    indices(std::move(other.indices)),
+    textures(std::move(other.textures)),
+    samplerNames(std::move(other.samplerNames)),
+    samplerLocations(std::move(other.samplerLocations)),
+    VAO(other.VAO),
+    VBO(other.VBO),
+    EBO(other.EBO),
+    indexType(other.indexType),
+    indexCount(other.indexCount),
+    gpuBytes(other.gpuBytes),
+    keepData(other.keepData),
+    worldSpace(other.worldSpace),
+    shininess(other.shininess),
+    shininessLocation(other.shininessLocation)
+{
+    other.VAO = 0;
+    other.VBO = 0;
+    other.EBO = 0;
+    other.indexCount = 0;
+    other.gpuBytes = 0;
+}
+
+Mesh& Mesh::operator=(Mesh &&other) noexcept
+{
+    if(this != &other)
+    {
+        DeleteBuffers();
+        vertices = std::move(other.vertices);
+        indices = std::move(other.indices);
+        textures = std::move(other.textures);
+        samplerNames = std::move(other.samplerNames);
+        samplerLocations = std::move(other.samplerLocations);
+        VAO = other.VAO;
+        VBO = other.VBO;
+        EBO = other.EBO;
+        indexType = other.indexType;
+        indexCount = other.indexCount;
+        gpuBytes = other.gpuBytes;
+        keepData = other.keepData;
+        worldSpace = other.worldSpace;
+        shininess = other.shininess;
+        shininessLocation = other.shininessLocation;
+
+        other.VAO = 0;
+        other.VBO = 0;
+        other.EBO = 0;
+        other.indexCount = 0;
+        other.gpuBytes = 0;
+    }
+
+    return *this;
+}
+
+Mesh::~Mesh()
+{
+    DeleteBuffers();
+}
+
+void Mesh::Upload()
+{
     glGenVertexArrays(1, &this->VAO);
     glGenBuffers(1, &this->VBO);
     glGenBuffers(1, &this->EBO);
 
     glBindVertexArray(this->VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
-    glBufferData(GL_ARRAY_BUFFER, this->vertices.size() * sizeof(Vertex),
-                 &this->vertices[0], GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->indices.size() * sizeof(unsigned int),
-                 &this->indices[0], GL_STATIC_DRAW);
+    UploadBuffers(this->vertices, this->indices);
+    ReleaseData();
 
-    // Vertex Positions
+    // Vertex Positions and the Texture Array Layer, packed models keep the layer in the fourth half of the position
     glEnableVertexAttribArray(Shader::PositionAttributeIndex);
-    glVertexAttribPointer(Shader::PositionAttributeIndex, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+    glEnableVertexAttribArray(Shader::LayerAttributeIndex);
+    if(worldSpace)
+    {
+        glVertexAttribPointer(Shader::PositionAttributeIndex, 3, GL_FLOAT, GL_FALSE, sizeof(WorldVertex), (void*)offsetof(WorldVertex, position));
+        glVertexAttribPointer(Shader::LayerAttributeIndex, 1, GL_FLOAT, GL_FALSE, sizeof(WorldVertex), (void*)offsetof(WorldVertex, layer));
+    }
+    else
+    {
+        glVertexAttribPointer(Shader::PositionAttributeIndex, 3, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, positionLayer));
+        glVertexAttribPointer(Shader::LayerAttributeIndex, 1, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)(offsetof(PackedVertex, positionLayer) + 3 * sizeof(glm::uint16)));
+    }
+
+    GLsizei stride = worldSpace ? sizeof(WorldVertex) : sizeof(PackedVertex);
+    size_t normalOffset = worldSpace ? offsetof(WorldVertex, normal) : offsetof(PackedVertex, normal);
+    size_t texCoordsOffset = worldSpace ? offsetof(WorldVertex, texCoords) : offsetof(PackedVertex, texCoords);
     // Vertex Normals
     glEnableVertexAttribArray(Shader::NormalAttributeIndex);
-    glVertexAttribPointer(Shader::NormalAttributeIndex, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+    glVertexAttribPointer(Shader::NormalAttributeIndex, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)normalOffset);
     // Vertex Texture Coords
     glEnableVertexAttribArray(Shader::TexCoordsAttributeIndex);
-    glVertexAttribPointer(Shader::TexCoordsAttributeIndex, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoords));
+    glVertexAttribPointer(Shader::TexCoordsAttributeIndex, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)texCoordsOffset);
 
     glBindVertexArray(0);
 }
 
-Mesh::~Mesh()
+void Mesh::SetKeepData(bool keepData)
 {
+    this->keepData = keepData;
 }
 
-void Mesh::Draw(Shader *shader)
+void Mesh::SetWorldSpace(bool worldSpace)
 {
-    unsigned int diffuseCount = 1;
-    unsigned int specularCount = 1;
-    for (unsigned int i = 0; i < this->textures.size(); ++i)
+    this->worldSpace = worldSpace;
+}
+
+void Mesh::LoadUniforms(Shader *shader)
+{
+    samplerLocations.clear();
+    for(const std::string &samplerName : samplerNames)
     {
-        glActiveTexture(GL_TEXTURE0 + i);
+        samplerLocations.push_back(shader->GetUniformLocation(samplerName));
+    }
 
-        std::stringstream ss;
-        std::string number;
-        std::string name = this->textures[i].type;
-        if(name == "texture_diffuse")
+    shininessLocation = shader->GetUniformLocation("material.shininess");
+}
+
+void Mesh::SetInstanceBuffer(unsigned int instanceBuffer)
+{
+    glBindVertexArray(this->VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+
+    // Per-instance model matrix, one vec4 column per attribute location
+    for(unsigned int i = 0; i < 4; ++i)
+    {
+        glEnableVertexAttribArray(Shader::ModelAttributeIndex + i);
+        glVertexAttribPointer(Shader::ModelAttributeIndex + i, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(offsetof(Instance, model) + sizeof(glm::vec4) * i));
+        glVertexAttribDivisor(Shader::ModelAttributeIndex + i, 1);
+    }
+    // And its normal matrix, one vec3 column per location
+    for(unsigned int i = 0; i < 3; ++i)
+    {
+        glEnableVertexAttribArray(Shader::NormalMatrixAttributeIndex + i);
+        glVertexAttribPointer(Shader::NormalMatrixAttributeIndex + i, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(offsetof(Instance, normalMatrix) + sizeof(glm::vec3) * i));
+        glVertexAttribDivisor(Shader::NormalMatrixAttributeIndex + i, 1);
+    }
+
+    glBindVertexArray(0);
+}
+
+void Mesh::SetData(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices)
+{
+    // Respecify the existing buffers straight from the caller's data, the vertex layout stays as set up in Upload
+    if(keepData)
+    {
+        this->vertices.assign(vertices.begin(), vertices.end());
+        this->indices.assign(indices.begin(), indices.end());
+    }
+
+    glBindVertexArray(this->VAO);
+    UploadBuffers(vertices, indices);
+    glBindVertexArray(0);
+}
+
+void Mesh::Draw(RenderState &state, int instanceCount)
+{
+    if(indexCount == 0)
+    {
+        return;
+    }
+
+    // Bindings are left in place for the next draw, the state skips the ones it shares
+    BindTextures(state);
+    state.BindVertexArray(this->VAO);
+    state.DrawElements((int)indexCount, indexType, instanceCount);
+}
+
+unsigned int Mesh::GetVertexArray()
+{
+    return VAO;
+}
+
+size_t Mesh::GetIndexCount()
+{
+    return indexCount;
+}
+
+size_t Mesh::GetCpuBytes()
+{
+    return vertices.capacity() * sizeof(Vertex) + indices.capacity() * sizeof(unsigned int);
+}
+
+size_t Mesh::GetGpuBytes()
+{
+    return gpuBytes;
+}
+
+std::vector<Vertex>& Mesh::GetVertices()
+{
+    return vertices;
+}
+
+std::vector<unsigned int>& Mesh::GetIndices()
+{
+    return indices;
+}
+
+std::vector<Texture>& Mesh::GetTextures()
+{
+    return textures;
+}
+
+void Mesh::BindTextures(RenderState &state)
+{
+    for(unsigned int i = 0; i < this->textures.size(); ++i)
+    {
+        state.SetSampler(samplerLocations[i], i);
+        state.BindTexture(i, this->textures[i].id);
+    }
+
+    state.SetShininess(shininessLocation, shininess);
+}
+
+void Mesh::UploadBuffers(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices)
+{
+    // Float vertices are what baking reads back from a kept mesh, only the GPU gets the packed layout
+    size_t vertexBytes;
+    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+    if(worldSpace)
+    {
+        std::vector<WorldVertex> &packed = worldScratch;
+        packed.resize(vertices.size());
+        for(size_t i = 0; i < vertices.size(); ++i)
         {
-            ss << diffuseCount++;
+            const Vertex &vertex = vertices[i];
+            packed[i].position = vertex.position;
+            packed[i].layer = vertex.layer;
+            packed[i].normal = glm::packSnorm3x10_1x2(glm::vec4(vertex.normal, 0.0f));
+            packed[i].texCoords = glm::packHalf2x16(vertex.texCoords);
         }
-        else if(name == "texture_specular")
+
+        vertexBytes = packed.size() * sizeof(WorldVertex);
+        glBufferData(GL_ARRAY_BUFFER, vertexBytes, packed.data(), GL_STATIC_DRAW);
+    }
+    else
+    {
+        std::vector<PackedVertex> &packed = packedScratch;
+        packed.resize(vertices.size());
+        for(size_t i = 0; i < vertices.size(); ++i)
         {
-            ss << specularCount++;
+            const Vertex &vertex = vertices[i];
+            packed[i].positionLayer = glm::packHalf4x16(glm::vec4(vertex.position, vertex.layer));
+            packed[i].normal = glm::packSnorm3x10_1x2(glm::vec4(vertex.normal, 0.0f));
+            packed[i].texCoords = glm::packHalf2x16(vertex.texCoords);
         }
-        number = ss.str();
 
-        std::string material = "material." + name + number;
-        shader->SetUniform(material.c_str(), i);
+        vertexBytes = packed.size() * sizeof(PackedVertex);
+        glBufferData(GL_ARRAY_BUFFER, vertexBytes, packed.data(), GL_STATIC_DRAW);
+    }
 
-        glBindTexture(GL_TEXTURE_2D, this->textures[i].id);
+    // Block models and level chunks stay well under 65536 vertices, their indices fit in 16 bits
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
+    size_t indexSize;
+    if(vertices.size() <= 65536)
+    {
+        std::vector<glm::uint16> &shortIndices = indexScratch;
+        shortIndices.assign(indices.begin(), indices.end());
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(glm::uint16), shortIndices.data(), GL_STATIC_DRAW);
+        indexType = GL_UNSIGNED_SHORT;
+        indexSize = sizeof(glm::uint16);
+    }
+    else
+    {
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+        indexType = GL_UNSIGNED_INT;
+        indexSize = sizeof(unsigned int);
     }
 
-    shader->SetUniform("material.shininess", shininess);
+    indexCount = indices.size();
+    gpuBytes = vertexBytes + indices.size() * indexSize;
+}
 
-    // Draw mesh
-    glBindVertexArray(this->VAO);
-    glDrawElements(GL_TRIANGLES, this->indices.size(), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+void Mesh::ReleaseData()
+{
+    if(keepData)
+    {
+        return;
+    }
 
-    for(unsigned int i = 0; i < this->textures.size(); ++i)
+    // Swapping with empty vectors gives the memory back, clear would keep the capacity
+    std::vector<Vertex>().swap(vertices);
+    std::vector<unsigned int>().swap(indices);
+}
+
+void Mesh::DeleteBuffers()
+{
+    // Meshes that were never uploaded, or were moved from, have no names to delete
+    if(VAO != 0)
+    {
+        glDeleteVertexArrays(1, &VAO);
+    }
+    if(VBO != 0)
+    {
+        glDeleteBuffers(1, &VBO);
+    }
+    if(EBO != 0)
     {
-        glActiveTexture(GL_TEXTURE0 + i);
-        glBindTexture(GL_TEXTURE_2D, 0);
+        glDeleteBuffers(1, &EBO);
     }
+
+    VAO = 0;
+    VBO = 0;
+    EBO = 0;
+    gpuBytes = 0;
 }
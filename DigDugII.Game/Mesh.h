@@ -3,16 +3,47 @@
 #include <string>
 #include <sstream>
 #include <vector>
+#include <utility>
 #include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
 #include <GL/glew.h>
 #include <assimp/Importer.hpp>
 #include "Shader.h"
+#include "RenderState.h"
 
 struct Vertex
 {
     glm::vec3 position;
     glm::vec3 normal;
     glm::vec2 texCoords;
+    // Layer of the block texture array, -1 samples the mesh's own diffuse texture
+    float layer;
+};
+
+// Vertex as the GPU stores it, 16 bytes instead of 36: half float position with the layer in its fourth
+// half, a 10:10:10:2 snorm normal and half float texture coordinates, which merged level faces repeat past 1
+struct PackedVertex
+{
+    glm::uint64 positionLayer;
+    glm::uint32 normal;
+    glm::uint32 texCoords;
+};
+
+// Vertex of world space geometry, 24 bytes. Halves only hold whole numbers exactly up to 2048 and step by
+// 0.5 past 512, so positions that span a large level stay full floats
+struct WorldVertex
+{
+    glm::vec3 position;
+    float layer;
+    glm::uint32 normal;
+    glm::uint32 texCoords;
+};
+
+// Per-instance attributes as a model's instance buffer holds them
+struct Instance
+{
+    glm::mat4 model;
+    glm::mat3 normalMatrix;
 };
 
 struct Texture
@@ -25,19 +56,64 @@ struct Texture
 class Mesh
 {
 public:
+    // The vectors are moved in, pass them with std::move to avoid a copy
     Mesh(std::vector<Vertex> vertices,
          std::vector<unsigned int> indices,
          std::vector<Texture> textures);
+    // A mesh owns its GL buffers and deletes them, moving it hands them over and copying is not allowed
+    Mesh(const Mesh&) = delete;
+    Mesh(Mesh &&other) noexcept;
+    Mesh& operator=(const Mesh&) = delete;
+    Mesh& operator=(Mesh &&other) noexcept;
     ~Mesh();
 
-    void Draw(Shader *shader);
+    // Construction only keeps the data and may run on any thread, Upload creates the GL buffers and then
+    // frees the CPU copy of the vertices and indices unless SetKeepData asked for them to be read back
+    void Upload();
+    void SetKeepData(bool keepData);
+    // Before Upload, keeps full float positions for vertices far from the origin
+    void SetWorldSpace(bool worldSpace);
+    void LoadUniforms(Shader *shader);
+    void SetInstanceBuffer(unsigned int instanceBuffer);
+    void SetData(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices);
+    // Draws instanceCount instances from the instance buffer, or the mesh once when it is 0
+    void Draw(RenderState &state, int instanceCount);
+
+    unsigned int GetVertexArray();
+    size_t GetIndexCount();
+    size_t GetCpuBytes();
+    size_t GetGpuBytes();
+
+    // Empty after Upload unless the mesh keeps its data
+    std::vector<Vertex>& GetVertices();
+    std::vector<unsigned int>& GetIndices();
+    std::vector<Texture>& GetTextures();
 
 private:
+    // Packing scratch shared by every mesh, only the GL thread uploads. It only grows, so rebaking a level
+    // chunk during a frame does not allocate once it has seen the largest chunk
+    static std::vector<PackedVertex> packedScratch;
+    static std::vector<WorldVertex> worldScratch;
+    static std::vector<glm::uint16> indexScratch;
+
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
     std::vector<Texture> textures;
+    std::vector<std::string> samplerNames;
+    std::vector<int> samplerLocations;
 
     unsigned int VAO, VBO, EBO;
+    unsigned int indexType;
+    size_t indexCount;
+    size_t gpuBytes;
+    bool keepData;
+    bool worldSpace;
     float shininess;
+    int shininessLocation;
+
+    void BindTextures(RenderState &state);
+    void UploadBuffers(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices);
+    void ReleaseData();
+    void DeleteBuffers();
 };
 
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <glm/glm.hpp>
+
+// Cooked model written by DigDugII.Cooker and memory-mapped by Model. The file is a header, a table of
+// meshes, then every mesh's vertices and indices. Offsets count bytes from the start of the file, and
+// vertices are stored in the runtime Vertex layout so they are used as they are. The header records the
+// size and modification time of the OBJ and its material library, a file whose sources changed is stale.
+namespace MeshFile
+{
+    const char Magic[4] = {'D', 'D', 'M', 'F'};
+    const uint32_t Version = 2;
+    const int PathLength = 64;
+    const char Extension[] = ".mesh";
+
+    struct SourceStamp
+    {
+        uint64_t size;
+        int64_t modified;
+    };
+
+    struct Header
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t vertexSize;
+        uint32_t meshCount;
+        SourceStamp model;
+        SourceStamp material;
+    };
+
+    // Every model names its material library after itself
+    inline std::string GetMaterialPath(const std::string &modelPath)
+    {
+        return modelPath.substr(0, modelPath.find_last_of('.')) + ".mtl";
+    }
+
+    // A missing file stamps as zero, so it still matches a cooked file made while it was missing
+    inline SourceStamp GetSourceStamp(const std::string &path)
+    {
+        SourceStamp stamp = {0, 0};
+        struct stat info;
+        if(stat(path.c_str(), &info) == 0)
+        {
+            stamp.size = (uint64_t)info.st_size;
+            stamp.modified = (int64_t)info.st_mtime;
+        }
+
+        return stamp;
+    }
+
+    inline bool SameStamp(const SourceStamp &a, const SourceStamp &b)
+    {
+        return a.size == b.size && a.modified == b.modified;
+    }
+
+    struct Vertex
+    {
+        glm::vec3 position;
+        glm::vec3 normal;
+        glm::vec2 texCoords;
+        float layer;
+    };
+
+    // Texture paths as the material file gives them, relative to the models directory, empty when unused
+    struct Entry
+    {
+        uint32_t vertexOffset;
+        uint32_t vertexCount;
+        uint32_t indexOffset;
+        uint32_t indexCount;
+        char diffuseTexture[PathLength];
+        char specularTexture[PathLength];
+    };
+}
@@ -0,0 +1,197 @@
+#include "MeshOptimizer.h"
+#include <cmath>
+
+namespace
+{
+    // Tom Forsyth's linear-speed vertex cache optimisation, scored against an LRU cache of this size
+    const int ScoringCacheSize = 32;
+    const float LastTriangleScore = 0.75f;
+    const float CacheDecayPower = 1.5f;
+    const float ValenceBoostScale = 2.0f;
+    const float ValenceBoostPower = 0.5f;
+
+    float VertexScore(int cachePosition, int remainingTriangles)
+    {
+        if(remainingTriangles == 0)
+        {
+            return -1.0f;
+        }
+
+        float score = 0.0f;
+        if(cachePosition >= 0)
+        {
+            // The three vertices of the triangle just added score the same so the next one is not favoured by order
+            if(cachePosition < 3)
+            {
+                score = LastTriangleScore;
+            }
+            else
+            {
+                score = std::pow(1.0f - (float)(cachePosition - 3) / (ScoringCacheSize - 3), CacheDecayPower);
+            }
+        }
+
+        // Vertices with few triangles left are finished first so they can leave the cache
+        return score + ValenceBoostScale * std::pow((float)remainingTriangles, -ValenceBoostPower);
+    }
+}
+
+float MeshOptimizer::ComputeACMR(const std::vector<unsigned int> &indices, size_t vertexCount)
+{
+    size_t triangleCount = indices.size() / 3;
+    if(triangleCount == 0)
+    {
+        return 0.0f;
+    }
+
+    // Each vertex remembers when it entered the cache, it is still there while fewer than CacheSize came after
+    std::vector<size_t> entered(vertexCount, 0);
+    size_t time = CacheSize + 1;
+    size_t misses = 0;
+    for(size_t i = 0; i < triangleCount * 3; ++i)
+    {
+        unsigned int vertex = indices[i];
+        if(time - entered[vertex] > CacheSize)
+        {
+            entered[vertex] = time++;
+            ++misses;
+        }
+    }
+
+    return (float)misses / triangleCount;
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<unsigned int> &indices, size_t vertexCount)
+{
+    size_t triangleCount = indices.size() / 3;
+    if(triangleCount == 0)
+    {
+        return;
+    }
+
+    // Triangles of every vertex, the first remaining[v] of them are the ones not emitted yet
+    std::vector<unsigned int> remaining(vertexCount, 0);
+    for(size_t i = 0; i < triangleCount * 3; ++i)
+    {
+        ++remaining[indices[i]];
+    }
+
+    std::vector<unsigned int> firstTriangle(vertexCount + 1, 0);
+    for(size_t v = 0; v < vertexCount; ++v)
+    {
+        firstTriangle[v + 1] = firstTriangle[v] + remaining[v];
+    }
+
+    std::vector<unsigned int> adjacency(triangleCount * 3);
+    std::vector<unsigned int> filled(vertexCount, 0);
+    for(size_t i = 0; i < triangleCount * 3; ++i)
+    {
+        unsigned int vertex = indices[i];
+        adjacency[firstTriangle[vertex] + filled[vertex]++] = (unsigned int)(i / 3);
+    }
+
+    std::vector<int> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for(size_t v = 0; v < vertexCount; ++v)
+    {
+        vertexScores[v] = VertexScore(-1, remaining[v]);
+    }
+
+    std::vector<bool> emitted(triangleCount, false);
+
+    std::vector<unsigned int> ordered;
+    ordered.reserve(triangleCount * 3);
+    std::vector<unsigned int> cache;
+    std::vector<unsigned int> nextCache;
+    size_t nextUnemitted = 0;
+    long long best = -1;
+
+    while(ordered.size() < triangleCount * 3)
+    {
+        // Nothing left around the cache, continue from the first triangle not emitted yet
+        if(best < 0)
+        {
+            while(emitted[nextUnemitted])
+            {
+                ++nextUnemitted;
+            }
+            best = (long long)nextUnemitted;
+        }
+
+        emitted[best] = true;
+        nextCache.clear();
+        for(int corner = 0; corner < 3; ++corner)
+        {
+            unsigned int vertex = indices[best * 3 + corner];
+            ordered.push_back(vertex);
+            nextCache.push_back(vertex);
+
+            // Drop the emitted triangle from the vertex's remaining ones
+            unsigned int *triangles = &adjacency[firstTriangle[vertex]];
+            for(unsigned int j = 0; j < remaining[vertex]; ++j)
+            {
+                if(triangles[j] == (unsigned int)best)
+                {
+                    std::swap(triangles[j], triangles[remaining[vertex] - 1]);
+                    --remaining[vertex];
+                    break;
+                }
+            }
+        }
+
+        for(unsigned int vertex : cache)
+        {
+            if(vertex != nextCache[0] && vertex != nextCache[1] && vertex != nextCache[2])
+            {
+                nextCache.push_back(vertex);
+            }
+        }
+
+        // Vertices pushed past the end leave the cache, every vertex that moved gets a new score
+        for(size_t i = 0; i < nextCache.size(); ++i)
+        {
+            unsigned int vertex = nextCache[i];
+            cachePositions[vertex] = i < (size_t)ScoringCacheSize ? (int)i : -1;
+            vertexScores[vertex] = VertexScore(cachePositions[vertex], remaining[vertex]);
+        }
+        if(nextCache.size() > (size_t)ScoringCacheSize)
+        {
+            nextCache.resize(ScoringCacheSize);
+        }
+        cache.swap(nextCache);
+
+        best = -1;
+        float bestScore = -1.0f;
+        for(unsigned int vertex : cache)
+        {
+            for(unsigned int j = 0; j < remaining[vertex]; ++j)
+            {
+                unsigned int triangle = adjacency[firstTriangle[vertex] + j];
+                float score = vertexScores[indices[triangle * 3]] + vertexScores[indices[triangle * 3 + 1]] + vertexScores[indices[triangle * 3 + 2]];
+                if(score > bestScore)
+                {
+                    bestScore = score;
+                    best = triangle;
+                }
+            }
+        }
+    }
+
+    indices.swap(ordered);
+}
+
+size_t MeshOptimizer::BuildFetchRemap(std::vector<unsigned int> &indices, size_t vertexCount, std::vector<unsigned int> &remap)
+{
+    remap.assign(vertexCount, ~0u);
+    unsigned int next = 0;
+    for(unsigned int &index : indices)
+    {
+        if(remap[index] == ~0u)
+        {
+            remap[index] = next++;
+        }
+        index = remap[index];
+    }
+
+    return next;
+}
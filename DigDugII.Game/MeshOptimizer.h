@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+// Import stage shared by Model and DigDugII.Cooker. Welding merges the per-corner vertices OBJ faces come
+// with, the triangle order is then chosen for the post-transform cache and the vertices renumbered in the
+// order the triangles first use them. Only the indices matter to the orderings, so they work on any vertex
+// type, welding compares vertices byte for byte.
+namespace MeshOptimizer
+{
+    // Average post-transform cache misses per triangle for a FIFO cache of this many vertices
+    const unsigned int CacheSize = 16;
+
+    float ComputeACMR(const std::vector<unsigned int> &indices, size_t vertexCount);
+    void OptimizeVertexCache(std::vector<unsigned int> &indices, size_t vertexCount);
+    // Renumbers the indices in order of first use, remap gets the new index of every old vertex or ~0u if unused
+    size_t BuildFetchRemap(std::vector<unsigned int> &indices, size_t vertexCount, std::vector<unsigned int> &remap);
+
+    template<typename VertexType>
+    void WeldVertices(std::vector<VertexType> &vertices, std::vector<unsigned int> &indices)
+    {
+        std::vector<unsigned int> order(vertices.size());
+        for(size_t i = 0; i < order.size(); ++i)
+        {
+            order[i] = (unsigned int)i;
+        }
+
+        // Sorting brings identical vertices together, each run keeps its first one
+        std::sort(order.begin(), order.end(), [&vertices](unsigned int a, unsigned int b)
+        {
+            int compared = std::memcmp(&vertices[a], &vertices[b], sizeof(VertexType));
+            return compared < 0 || (compared == 0 && a < b);
+        });
+
+        std::vector<unsigned int> remap(vertices.size());
+        for(size_t i = 0; i < order.size(); ++i)
+        {
+            bool same = i > 0 && std::memcmp(&vertices[order[i]], &vertices[order[i - 1]], sizeof(VertexType)) == 0;
+            remap[order[i]] = same ? remap[order[i - 1]] : order[i];
+        }
+
+        for(unsigned int &index : indices)
+        {
+            index = remap[index];
+        }
+    }
+
+    template<typename VertexType>
+    void OptimizeVertexFetch(std::vector<VertexType> &vertices, std::vector<unsigned int> &indices)
+    {
+        std::vector<unsigned int> remap;
+        size_t vertexCount = BuildFetchRemap(indices, vertices.size(), remap);
+
+        std::vector<VertexType> ordered(vertexCount);
+        for(size_t i = 0; i < vertices.size(); ++i)
+        {
+            if(remap[i] != ~0u)
+            {
+                ordered[remap[i]] = vertices[i];
+            }
+        }
+        vertices.swap(ordered);
+    }
+
+    // Weld, reorder for the cache, then for fetch, which also drops the vertices welding left unused
+    template<typename VertexType>
+    void Optimize(std::vector<VertexType> &vertices, std::vector<unsigned int> &indices)
+    {
+        WeldVertices(vertices, indices);
+        OptimizeVertexCache(indices, vertices.size());
+        OptimizeVertexFetch(vertices, indices);
+    }
+}
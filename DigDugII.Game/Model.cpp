@@ -1,37 +1,314 @@
 #include "Model.h"
 
 const std::string Model::modelDir("../Resources/models/");
+// Written by DigDugII.Cooker, a model that was not cooked is imported from modelDir instead
+const std::string Model::cookedDir("../Resources/cooked/");
 
-Model::Model(std::string name)
-    : modelName(name)
+static_assert(sizeof(Vertex) == sizeof(MeshFile::Vertex), "Cooked vertices must match the Vertex layout");
+
+Model::Model(std::string name, TextureArray *textureArray, bool keepMeshData)
+    : modelName(name),
+    instanceVBO(0),
+    instanceBufferBytes(0),
+    keepMeshData(keepMeshData),
+    textureArray(textureArray),
+    cooked(false),
+    optimizeStats()
 {
-    loadModel();
 }
 
 Model::~Model()
 {
+    for(Texture &texture : textures)
+    {
+        TextureCache::Release(texture.id);
+    }
+
+    if(instanceVBO != 0)
+    {
+        glDeleteBuffers(1, &instanceVBO);
+    }
+}
+
+void Model::Load()
+{
+    // Cooked meshes were merged and optimized by the cooker already
+    cooked = loadModel();
+    if(!cooked)
+    {
+        optimizeMeshes();
+    }
+}
+
+void Model::Upload()
+{
+    // Textures were decoded during Load, acquiring them only uploads them or shares a copy already there
+    for(Mesh &mesh : meshes)
+    {
+        mesh.SetKeepData(keepMeshData);
+        mesh.Upload();
+        for(Texture &texture : mesh.GetTextures())
+        {
+            texture.id = TextureCache::Acquire(modelDir + texture.path.C_Str());
+            textures.push_back(texture);
+        }
+    }
+
+    // Every mesh of the model is drawn once per instance from the same matrix buffer
+    glGenBuffers(1, &instanceVBO);
+    for(Mesh &mesh : meshes)
+    {
+        mesh.SetInstanceBuffer(instanceVBO);
+    }
+}
+
+const std::string& Model::GetName()
+{
+    return modelName;
+}
+
+bool Model::IsCooked()
+{
+    return cooked;
+}
+
+const Model::OptimizeStats& Model::GetOptimizeStats()
+{
+    return optimizeStats;
+}
+
+size_t Model::GetCpuBytes()
+{
+    size_t bytes = instances.capacity() * sizeof(Instance);
+    for(Mesh &mesh : meshes)
+    {
+        bytes += mesh.GetCpuBytes();
+    }
+
+    return bytes;
+}
+
+size_t Model::GetGpuBytes()
+{
+    size_t bytes = instanceBufferBytes;
+    for(Mesh &mesh : meshes)
+    {
+        bytes += mesh.GetGpuBytes();
+    }
+
+    return bytes;
 }
 
-void Model::Draw(Shader *shader)
+void Model::LoadUniforms(Shader *shader)
 {
-    for(Mesh mesh : meshes)
+    for(Mesh &mesh : meshes)
     {
-        mesh.Draw(shader);
+        mesh.LoadUniforms(shader);
     }
 }
 
-void Model::loadModel()
+void Model::AddInstance(const glm::mat4 &modelMatrix, const glm::mat3 &normalMatrix)
 {
+    instances.push_back({modelMatrix, normalMatrix});
+}
+
+void Model::UploadInstances()
+{
+    if(instances.empty())
+    {
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(Instance), &instances[0], GL_STREAM_DRAW);
+    instanceBufferBytes = instances.size() * sizeof(Instance);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Model::QueueInstances(RenderQueue &queue, Shader *shader)
+{
+    if(instances.empty())
+    {
+        return;
+    }
+
+    // Instances are spread over the level, with no single depth they sort first among equal state
+    for(Mesh &mesh : meshes)
+    {
+        queue.Add(&mesh, shader, instances.size(), 0.0f);
+    }
+}
+
+void Model::ClearInstances()
+{
+    instances.clear();
+}
+
+std::vector<Mesh>& Model::GetMeshes()
+{
+    return meshes;
+}
+
+bool Model::loadModel()
+{
+    if(loadCookedModel())
+    {
+        return true;
+    }
+
     Assimp::Importer import;
     const aiScene* scene = import.ReadFile(modelDir + modelName, aiProcess_Triangulate | aiProcess_FlipUVs);
 
     if(!scene || scene->mFlags == AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
     {
         std::cerr << "ERROR::ASSIMP::" << import.GetErrorString() << std::endl;
-        return;
+        return false;
     }
 
     processNode(scene->mRootNode, scene);
+    return false;
+}
+
+void Model::optimizeMeshes()
+{
+    // Meshes with the same textures become one draw, with the texture array that is every block mesh
+    std::vector<Mesh> merged;
+    size_t trianglesBefore = 0;
+    float missesBefore = 0.0f;
+    for(Mesh &mesh : meshes)
+    {
+        std::vector<Vertex> &vertices = mesh.GetVertices();
+        std::vector<unsigned int> &indices = mesh.GetIndices();
+        optimizeStats.verticesBefore += vertices.size();
+        trianglesBefore += indices.size() / 3;
+        missesBefore += MeshOptimizer::ComputeACMR(indices, vertices.size()) * (indices.size() / 3);
+
+        Mesh *target = nullptr;
+        for(Mesh &candidate : merged)
+        {
+            std::vector<Texture> &a = candidate.GetTextures();
+            std::vector<Texture> &b = mesh.GetTextures();
+            bool same = a.size() == b.size();
+            for(size_t i = 0; i < a.size() && same; ++i)
+            {
+                same = a[i].type == b[i].type && a[i].path == b[i].path;
+            }
+            if(same)
+            {
+                target = &candidate;
+                break;
+            }
+        }
+
+        if(target == nullptr)
+        {
+            merged.push_back(std::move(mesh));
+            continue;
+        }
+
+        std::vector<Vertex> &targetVertices = target->GetVertices();
+        std::vector<unsigned int> &targetIndices = target->GetIndices();
+        unsigned int offset = (unsigned int)targetVertices.size();
+        targetVertices.insert(targetVertices.end(), vertices.begin(), vertices.end());
+        for(unsigned int index : indices)
+        {
+            targetIndices.push_back(index + offset);
+        }
+    }
+
+    size_t trianglesAfter = 0;
+    float missesAfter = 0.0f;
+    for(Mesh &mesh : merged)
+    {
+        std::vector<Vertex> &vertices = mesh.GetVertices();
+        std::vector<unsigned int> &indices = mesh.GetIndices();
+        MeshOptimizer::Optimize(vertices, indices);
+        optimizeStats.verticesAfter += vertices.size();
+        trianglesAfter += indices.size() / 3;
+        missesAfter += MeshOptimizer::ComputeACMR(indices, vertices.size()) * (indices.size() / 3);
+    }
+
+    optimizeStats.meshesBefore = meshes.size();
+    optimizeStats.meshesAfter = merged.size();
+    optimizeStats.acmrBefore = trianglesBefore > 0 ? missesBefore / trianglesBefore : 0.0f;
+    optimizeStats.acmrAfter = trianglesAfter > 0 ? missesAfter / trianglesAfter : 0.0f;
+    meshes.swap(merged);
+}
+
+bool Model::loadCookedModel()
+{
+    std::string cookedName = modelName.substr(0, modelName.find_last_of('.')) + MeshFile::Extension;
+    MappedFile file;
+    if(!file.Open(cookedDir + cookedName))
+    {
+        return false;
+    }
+
+    const unsigned char *data = file.GetData();
+    size_t size = file.GetSize();
+    const MeshFile::Header *header = (const MeshFile::Header*)data;
+    if(size < sizeof(MeshFile::Header) || std::memcmp(header->magic, MeshFile::Magic, sizeof(header->magic)) != 0 ||
+       header->version != MeshFile::Version || header->vertexSize != sizeof(Vertex) ||
+       size < sizeof(MeshFile::Header) + (size_t)header->meshCount * sizeof(MeshFile::Entry))
+    {
+        std::cerr << "ERROR::MODEL::COOKED_FILE_INVALID " << cookedName << std::endl;
+        return false;
+    }
+
+    // The OBJ or its materials changed since cooking, import them instead of loading old geometry
+    std::string modelPath = modelDir + modelName;
+    if(!MeshFile::SameStamp(header->model, MeshFile::GetSourceStamp(modelPath)) ||
+       !MeshFile::SameStamp(header->material, MeshFile::GetSourceStamp(MeshFile::GetMaterialPath(modelPath))))
+    {
+        std::cerr << "ERROR::MODEL::COOKED_FILE_STALE " << cookedName << std::endl;
+        return false;
+    }
+
+    const MeshFile::Entry *entries = (const MeshFile::Entry*)(data + sizeof(MeshFile::Header));
+    for(uint32_t i = 0; i < header->meshCount; ++i)
+    {
+        const MeshFile::Entry &entry = entries[i];
+        if(entry.vertexOffset + (size_t)entry.vertexCount * sizeof(Vertex) > size ||
+           entry.indexOffset + (size_t)entry.indexCount * sizeof(unsigned int) > size)
+        {
+            std::cerr << "ERROR::MODEL::COOKED_FILE_INVALID " << cookedName << std::endl;
+            meshes.clear();
+            return false;
+        }
+
+        // The mapped vertices are already in the runtime layout, only the array layer is filled in here
+        const Vertex *vertexData = (const Vertex*)(data + entry.vertexOffset);
+        const unsigned int *indexData = (const unsigned int*)(data + entry.indexOffset);
+        std::vector<Vertex> vertices(vertexData, vertexData + entry.vertexCount);
+        std::vector<unsigned int> indices(indexData, indexData + entry.indexCount);
+        std::vector<Texture> textures;
+
+        std::string diffuseTexture(entry.diffuseTexture, strnlen(entry.diffuseTexture, MeshFile::PathLength));
+        std::string specularTexture(entry.specularTexture, strnlen(entry.specularTexture, MeshFile::PathLength));
+        if(textureArray != nullptr)
+        {
+            float layer = diffuseTexture.empty() ? -1.0f : (float)textureArray->AddLayer(modelDir + diffuseTexture);
+            for(Vertex &vertex : vertices)
+            {
+                vertex.layer = layer;
+            }
+        }
+        else
+        {
+            if(!diffuseTexture.empty())
+            {
+                textures.push_back(requestTexture(diffuseTexture, "texture_diffuse"));
+            }
+            if(!specularTexture.empty())
+            {
+                textures.push_back(requestTexture(specularTexture, "texture_specular"));
+            }
+        }
+
+        meshes.push_back(Mesh(std::move(vertices), std::move(indices), std::move(textures)));
+    }
+
+    return true;
 }
 
 void Model::processNode(aiNode * node, const aiScene * scene)
@@ -53,6 +330,18 @@ Mesh Model::processMesh(aiMesh * mesh, const aiScene * scene)
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
     std::vector<Texture> textures;
+    float layer = -1.0f;
+
+    // Array layers replace the mesh's textures, every vertex carries the layer of its material
+    if(textureArray != nullptr && mesh->mMaterialIndex >= 0)
+    {
+        aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+        aiString texturePath;
+        if(material->GetTextureCount(aiTextureType_DIFFUSE) > 0 && material->GetTexture(aiTextureType_DIFFUSE, 0, &texturePath) == AI_SUCCESS)
+        {
+            layer = (float)textureArray->AddLayer(modelDir + texturePath.C_Str());
+        }
+    }
 
     for(unsigned int i = 0; i < mesh->mNumVertices; ++i)
     {
@@ -86,6 +375,8 @@ Mesh Model::processMesh(aiMesh * mesh, const aiScene * scene)
             vertex.texCoords = glm::vec2(0.0f, 0.0f);
         }
 
+        vertex.layer = layer;
+
         vertices.push_back(vertex);
     }
 
@@ -100,7 +391,7 @@ Mesh Model::processMesh(aiMesh * mesh, const aiScene * scene)
     }
 
     // Process materials
-    if(mesh->mMaterialIndex >= 0)
+    if(textureArray == nullptr && mesh->mMaterialIndex >= 0)
     {
         aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
 
@@ -114,7 +405,7 @@ Mesh Model::processMesh(aiMesh * mesh, const aiScene * scene)
     }
 
     // Return a mesh object created from the extracted mesh data
-    return Mesh(vertices, indices, textures);
+    return Mesh(std::move(vertices), std::move(indices), std::move(textures));
 }
 
 std::vector<Texture> Model::loadMaterialTextures(aiMaterial * mat, aiTextureType type, std::string typeName)
@@ -124,58 +415,19 @@ std::vector<Texture> Model::loadMaterialTextures(aiMaterial * mat, aiTextureType
     {
         aiString texturePath;
         mat->GetTexture(type, i, &texturePath);
-        // Check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-        bool skip = false;
-        for(unsigned int j = 0; j < textures.size(); ++j)
-        {
-            if (textures[j].path == texturePath)
-            {
-                textures.push_back(textures[j]);
-                skip = true; // A texture with the same filepath has already been loaded, continue to next one. (optimization)
-                break;
-            }
-        }
-
-        if(!skip)
-        {   // If texture hasn't been loaded already, load it
-            Texture texture;
-            texture.id = loadTexture(texturePath.C_Str());
-            texture.type = typeName;
-            texture.path = texturePath;
-            textures.push_back(texture);
-            this->textures.push_back(texture);  // Store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
-        }
+        textures.push_back(requestTexture(texturePath.C_Str(), typeName));
     }
 
     return textures;
 }
 
-unsigned int Model::loadTexture(std::string path)
+Texture Model::requestTexture(const std::string &path, std::string typeName)
 {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-    int width, height;
-
-    std::string texturePath = modelDir + path;
-    FREE_IMAGE_FORMAT format = FreeImage_GetFileType(texturePath.c_str());
-    FIBITMAP *image = FreeImage_Load(format, texturePath.c_str());
-    image = FreeImage_ConvertTo32Bits(image);
-
-    width = FreeImage_GetWidth(image);
-    height = FreeImage_GetHeight(image);
-
-    // Assign texture to ID
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_BGRA, GL_UNSIGNED_BYTE, (void*)FreeImage_GetBits(image));
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    // Parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    FreeImage_Unload(image);
-    return textureID;
+    // The image is decoded now, the texture only gets its GL name from the cache in Upload
+    Texture texture;
+    texture.id = 0;
+    texture.type = typeName;
+    texture.path = aiString(path);
+    TextureCache::Prefetch(modelDir + path);
+    return texture;
 }
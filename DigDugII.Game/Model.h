@@ -3,31 +3,81 @@
 #include <string>
 #include <vector>
 #include <iostream>
+#include <cstring>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include <FreeImage.h>
 #include "Mesh.h"
+#include "RenderQueue.h"
+#include "TextureArray.h"
+#include "TextureCache.h"
+#include "MappedFile.h"
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
 
 class Model
 {
 public:
-    Model(std::string name);
+    // Vertex count and post-transform cache misses per triangle of the whole model around the import stage
+    struct OptimizeStats
+    {
+        size_t meshesBefore;
+        size_t meshesAfter;
+        size_t verticesBefore;
+        size_t verticesAfter;
+        float acmrBefore;
+        float acmrAfter;
+    };
+
+    // With a texture array the diffuse textures become layers of it instead of textures of their own.
+    // keepMeshData leaves the CPU copy of the meshes after upload for code that reads them back
+    Model(std::string name, TextureArray *textureArray = nullptr, bool keepMeshData = false);
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
     ~Model();
 
-    void Draw(Shader *shader);
+    // Load parses the model and decodes its textures on any thread, Upload then runs on the GL thread
+    void Load();
+    void Upload();
+    const std::string& GetName();
+    // Whether Load mapped a cooked file, the optimize stats are only filled for models imported from OBJ
+    bool IsCooked();
+    const OptimizeStats& GetOptimizeStats();
+    // Mesh data and instance matrices, textures are shared and counted by TextureCache and TextureArray
+    size_t GetCpuBytes();
+    size_t GetGpuBytes();
+
+    void LoadUniforms(Shader *shader);
+    void AddInstance(const glm::mat4 &modelMatrix, const glm::mat3 &normalMatrix);
+    void UploadInstances();
+    void QueueInstances(RenderQueue &queue, Shader *shader);
+    void ClearInstances();
+
+    std::vector<Mesh>& GetMeshes();
 
 private:
     static const std::string modelDir;
+    static const std::string cookedDir;
 
     std::string modelName;
     std::vector<Mesh> meshes;
     std::vector<Texture> textures;
+    std::vector<Instance> instances;
+    unsigned int instanceVBO;
+    size_t instanceBufferBytes;
+    bool keepMeshData;
+    TextureArray *textureArray;
+    bool cooked;
+    OptimizeStats optimizeStats;
 
-    void loadModel();
+    // Returns whether the cooked file was used instead of the OBJ import
+    bool loadModel();
+    void optimizeMeshes();
+    bool loadCookedModel();
     void processNode(aiNode* node, const aiScene* scene);
     Mesh processMesh(aiMesh* mesh, const aiScene* scene);
     std::vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName);
-    unsigned int loadTexture(std::string path);
+    Texture requestTexture(const std::string &path, std::string typeName);
 };
 
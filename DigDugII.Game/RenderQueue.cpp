@@ -0,0 +1,53 @@
+#include "RenderQueue.h"
+
+RenderQueue::RenderQueue()
+{
+}
+
+RenderQueue::~RenderQueue()
+{
+}
+
+void RenderQueue::Add(Mesh *mesh, Shader *shader, int instanceCount, float depth)
+{
+    if(mesh->GetIndexCount() == 0)
+    {
+        return;
+    }
+
+    items.push_back({0, mesh, shader, instanceCount, depth});
+}
+
+void RenderQueue::Flush(RenderState &state)
+{
+    float farthest = 0.0f;
+    for(const DrawItem &item : items)
+    {
+        farthest = std::max(farthest, item.depth);
+    }
+
+    // Key from high to low bits: program 8, first texture 20, vertex array 20, depth 16
+    for(DrawItem &item : items)
+    {
+        unsigned long long program = item.shader->GetProgram() & 0xFF;
+        unsigned long long texture = item.mesh->GetTextures().empty() ? 0 : item.mesh->GetTextures()[0].id & 0xFFFFF;
+        unsigned long long vertexArray = item.mesh->GetVertexArray() & 0xFFFFF;
+        unsigned long long depth = farthest > 0.0f ? (unsigned long long)(std::max(item.depth, 0.0f) / farthest * 0xFFFF) : 0;
+        item.key = (program << 56) | (texture << 36) | (vertexArray << 16) | depth;
+    }
+
+    std::sort(items.begin(), items.end(), CompareKeys);
+
+    for(DrawItem &item : items)
+    {
+        state.UseProgram(item.shader->GetProgram());
+        item.mesh->Draw(state, item.instanceCount);
+    }
+
+    items.clear();
+}
+
+bool RenderQueue::CompareKeys(const DrawItem &a, const DrawItem &b)
+{
+    return a.key < b.key;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include "Shader.h"
+#include "Mesh.h"
+#include "RenderState.h"
+
+// Draws of one pass collected first and issued sorted by program, texture and vertex array, then front
+// to back, so consecutive draws share their bindings and near geometry fills the depth buffer first.
+class RenderQueue
+{
+public:
+    RenderQueue();
+    ~RenderQueue();
+
+    void Add(Mesh *mesh, Shader *shader, int instanceCount, float depth);
+    void Flush(RenderState &state);
+
+private:
+    struct DrawItem
+    {
+        unsigned long long key;
+        Mesh *mesh;
+        Shader *shader;
+        int instanceCount;
+        float depth;
+    };
+
+    std::vector<DrawItem> items;
+
+    static bool CompareKeys(const DrawItem &a, const DrawItem &b);
+};
@@ -0,0 +1,135 @@
+#include "RenderState.h"
+
+RenderState::RenderState()
+{
+    Reset();
+    ResetStats();
+}
+
+RenderState::~RenderState()
+{
+}
+
+void RenderState::Reset()
+{
+    // Nothing is known about GL after a reset, ~0 never matches a real name so the next bind goes through
+    program = ~0u;
+    vertexArray = ~0u;
+    activeUnit = ~0u;
+    for(unsigned int i = 0; i < TextureUnits; ++i)
+    {
+        textures[i] = ~0u;
+        samplers[i] = -1;
+    }
+
+    shininessLocation = -1;
+    shininess = 0.0f;
+}
+
+void RenderState::ResetStats()
+{
+    stats = Stats();
+}
+
+const RenderState::Stats& RenderState::GetStats()
+{
+    return stats;
+}
+
+void RenderState::UseProgram(unsigned int program)
+{
+    if(this->program == program)
+    {
+        return;
+    }
+
+    // Uniforms belong to the program, the cached values are only valid for the previous one
+    glUseProgram(program);
+    this->program = program;
+    for(unsigned int i = 0; i < TextureUnits; ++i)
+    {
+        samplers[i] = -1;
+    }
+    shininessLocation = -1;
+    ++stats.programChanges;
+}
+
+void RenderState::BindVertexArray(unsigned int vertexArray)
+{
+    if(this->vertexArray == vertexArray)
+    {
+        return;
+    }
+
+    glBindVertexArray(vertexArray);
+    this->vertexArray = vertexArray;
+    ++stats.vertexArrayChanges;
+}
+
+void RenderState::BindTexture(unsigned int unit, unsigned int texture)
+{
+    if(unit >= TextureUnits || textures[unit] == texture)
+    {
+        return;
+    }
+
+    if(activeUnit != unit)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        activeUnit = unit;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, texture);
+    textures[unit] = texture;
+    ++stats.textureChanges;
+}
+
+void RenderState::SetSampler(int location, unsigned int unit)
+{
+    // A sampler uniform keeps its unit, meshes sharing the uniform names only need it set once
+    if(location < 0 || (unit < TextureUnits && samplers[unit] == location))
+    {
+        return;
+    }
+
+    glUniform1i(location, (int)unit);
+    for(unsigned int i = 0; i < TextureUnits; ++i)
+    {
+        if(samplers[i] == location)
+        {
+            samplers[i] = -1;
+        }
+    }
+    if(unit < TextureUnits)
+    {
+        samplers[unit] = location;
+    }
+    ++stats.uniformChanges;
+}
+
+void RenderState::SetShininess(int location, float shininess)
+{
+    if(location < 0 || (shininessLocation == location && this->shininess == shininess))
+    {
+        return;
+    }
+
+    glUniform1f(location, shininess);
+    shininessLocation = location;
+    this->shininess = shininess;
+    ++stats.uniformChanges;
+}
+
+void RenderState::DrawElements(int count, unsigned int indexType, int instanceCount)
+{
+    if(instanceCount > 0)
+    {
+        glDrawElementsInstanced(GL_TRIANGLES, count, indexType, 0, instanceCount);
+    }
+    else
+    {
+        glDrawElements(GL_TRIANGLES, count, indexType, 0);
+    }
+
+    ++stats.drawCalls;
+}
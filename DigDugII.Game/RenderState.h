@@ -0,0 +1,44 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// Shadow copy of the GL bindings the renderer touches, so a bind that would not change anything is
+// skipped. Every call that reaches GL is counted, the counts are reset at the start of each frame.
+class RenderState
+{
+public:
+    struct Stats
+    {
+        int drawCalls;
+        int programChanges;
+        int vertexArrayChanges;
+        int textureChanges;
+        int uniformChanges;
+    };
+
+    RenderState();
+    ~RenderState();
+
+    void Reset();
+    void ResetStats();
+    const Stats& GetStats();
+
+    void UseProgram(unsigned int program);
+    void BindVertexArray(unsigned int vertexArray);
+    void BindTexture(unsigned int unit, unsigned int texture);
+    void SetSampler(int location, unsigned int unit);
+    void SetShininess(int location, float shininess);
+    void DrawElements(int count, unsigned int indexType, int instanceCount);
+
+private:
+    static const unsigned int TextureUnits = 16;
+
+    Stats stats;
+    unsigned int program;
+    unsigned int vertexArray;
+    unsigned int activeUnit;
+    unsigned int textures[TextureUnits];
+    int samplers[TextureUnits];
+    int shininessLocation;
+    float shininess;
+};
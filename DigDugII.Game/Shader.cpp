@@ -10,6 +10,9 @@ Shader::Shader(std::string name)
     glBindAttribLocation(program, PositionAttributeIndex, "position");
     glBindAttribLocation(program, NormalAttributeIndex, "normal");
     glBindAttribLocation(program, TexCoordsAttributeIndex, "texCoords");
+    glBindAttribLocation(program, ModelAttributeIndex, "model");
+    glBindAttribLocation(program, LayerAttributeIndex, "layer");
+    glBindAttribLocation(program, NormalMatrixAttributeIndex, "normalMatrix");
 
     glAttachShader(program, vertexShader);
     glAttachShader(program, fragmentShader);
@@ -30,6 +33,8 @@ Shader::Shader(std::string name)
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
 
+    ReflectUniforms();
+
     glUseProgram(program);
 }
 
@@ -44,30 +49,68 @@ unsigned int Shader::GetProgram()
     return program;
 }
 
-void Shader::SetUniform(std::string name, float value)
+int Shader::GetUniformLocation(const std::string &name)
+{
+    auto location = uniformLocations.find(name);
+    if(location == uniformLocations.end())
+    {
+        // Not an active uniform, setting location -1 is silently ignored by GL
+        return -1;
+    }
+
+    return location->second;
+}
+
+void Shader::SetUniform(int location, int value)
+{
+    glUniform1i(location, value);
+}
+
+void Shader::SetUniform(int location, float value)
 {
-    int location = glGetUniformLocation(program, name.c_str());
     glUniform1f(location, value);
 }
 
-void Shader::SetUniform(std::string name, glm::vec2 value)
+void Shader::SetUniform(int location, const glm::vec2 &value)
 {
-    int location = glGetUniformLocation(program, name.c_str());
     glUniform2f(location, value.x, value.y);
 }
 
-void Shader::SetUniform(std::string name, glm::vec3 value)
+void Shader::SetUniform(int location, const glm::vec3 &value)
 {
-    int location = glGetUniformLocation(program, name.c_str());
     glUniform3f(location, value.x, value.y, value.z);
 }
 
-void Shader::SetUniform(std::string name, glm::mat4 value)
+void Shader::SetUniform(int location, const glm::mat4 &value)
 {
-    int location = glGetUniformLocation(program, name.c_str());
     glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
 }
 
+void Shader::SetUniform(const std::string &name, int value)
+{
+    SetUniform(GetUniformLocation(name), value);
+}
+
+void Shader::SetUniform(const std::string &name, float value)
+{
+    SetUniform(GetUniformLocation(name), value);
+}
+
+void Shader::SetUniform(const std::string &name, const glm::vec2 &value)
+{
+    SetUniform(GetUniformLocation(name), value);
+}
+
+void Shader::SetUniform(const std::string &name, const glm::vec3 &value)
+{
+    SetUniform(GetUniformLocation(name), value);
+}
+
+void Shader::SetUniform(const std::string &name, const glm::mat4 &value)
+{
+    SetUniform(GetUniformLocation(name), value);
+}
+
 unsigned int Shader::CompileShader(int type, std::string name)
 {
     std::string ext(type == GL_VERTEX_SHADER ? "vert" : "frag");
@@ -95,3 +138,30 @@ unsigned int Shader::CompileShader(int type, std::string name)
 
     return shader;
 }
+
+void Shader::ReflectUniforms()
+{
+    int count;
+    int maxLength;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::string buffer(maxLength, ' ');
+    for(int i = 0; i < count; ++i)
+    {
+        int length;
+        int size;
+        GLenum type;
+        glGetActiveUniform(program, i, maxLength, &length, &size, &type, &buffer[0]);
+
+        std::string name(buffer, 0, length);
+        int location = glGetUniformLocation(program, name.c_str());
+        uniformLocations[name] = location;
+
+        // Arrays of plain types are reported as "name[0]", make them reachable by their bare name too
+        if(name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+        {
+            uniformLocations[name.substr(0, name.size() - 3)] = location;
+        }
+    }
+}
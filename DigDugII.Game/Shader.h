@@ -4,6 +4,7 @@
 #include <fstream>
 #include <streambuf>
 #include <iostream>
+#include <unordered_map>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -14,20 +15,35 @@ public:
     static const unsigned int PositionAttributeIndex = 0;
     static const unsigned int NormalAttributeIndex = 1;
     static const unsigned int TexCoordsAttributeIndex = 2;
+    // A mat4 attribute takes four consecutive locations, 3 to 6
+    static const unsigned int ModelAttributeIndex = 3;
+    static const unsigned int LayerAttributeIndex = 7;
+    // A mat3 attribute takes three, 8 to 10
+    static const unsigned int NormalMatrixAttributeIndex = 8;
 
     Shader(std::string name);
     ~Shader();
 
     unsigned int GetProgram();
+    int GetUniformLocation(const std::string &name);
 
-    void SetUniform(std::string name, float value);
-    void SetUniform(std::string name, glm::vec2 value);
-    void SetUniform(std::string name, glm::vec3 value);
-    void SetUniform(std::string name, glm::mat4 value);
+    void SetUniform(int location, int value);
+    void SetUniform(int location, float value);
+    void SetUniform(int location, const glm::vec2 &value);
+    void SetUniform(int location, const glm::vec3 &value);
+    void SetUniform(int location, const glm::mat4 &value);
+
+    void SetUniform(const std::string &name, int value);
+    void SetUniform(const std::string &name, float value);
+    void SetUniform(const std::string &name, const glm::vec2 &value);
+    void SetUniform(const std::string &name, const glm::vec3 &value);
+    void SetUniform(const std::string &name, const glm::mat4 &value);
 
 private:
     unsigned int program;
+    std::unordered_map<std::string, int> uniformLocations;
 
     unsigned int CompileShader(int type, std::string name);
+    void ReflectUniforms();
 };
 
@@ -0,0 +1,134 @@
+#include "TextureArray.h"
+
+TextureArray::TextureArray()
+    : texture(0),
+    width(0),
+    height(0)
+{
+}
+
+TextureArray::~TextureArray()
+{
+    for(Layer &layer : layers)
+    {
+        if(layer.image != nullptr)
+        {
+            FreeImage_Unload(layer.image);
+        }
+    }
+}
+
+int TextureArray::AddLayer(const std::string &path)
+{
+    std::string resolved = TextureCache::ResolvePath(path);
+    size_t index;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for(size_t i = 0; i < layers.size(); ++i)
+        {
+            if(layers[i].path == resolved)
+            {
+                return (int)i;
+            }
+        }
+
+        // The slot is claimed before decoding so models loading on other threads get the same layer
+        layers.push_back({resolved, nullptr});
+        index = layers.size() - 1;
+    }
+
+    FREE_IMAGE_FORMAT format = FreeImage_GetFileType(resolved.c_str());
+    FIBITMAP *image = FreeImage_Load(format, resolved.c_str());
+    if(image == nullptr)
+    {
+        std::cerr << "ERROR::TEXTURE_ARRAY::LAYER_NOT_FOUND " << resolved << std::endl;
+        return -1;
+    }
+
+    FIBITMAP *converted = FreeImage_ConvertTo32Bits(image);
+    FreeImage_Unload(image);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    layers[index].image = converted;
+    return (int)index;
+}
+
+void TextureArray::Upload()
+{
+    if(layers.empty())
+    {
+        return;
+    }
+
+    for(Layer &layer : layers)
+    {
+        if(layer.image == nullptr)
+        {
+            continue;
+        }
+        width = std::max(width, FreeImage_GetWidth(layer.image));
+        height = std::max(height, FreeImage_GetHeight(layer.image));
+    }
+    if(width == 0 || height == 0)
+    {
+        return;
+    }
+
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, layers.size(), 0, GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
+
+    for(size_t i = 0; i < layers.size(); ++i)
+    {
+        // Box filtering keeps the small pixel art textures sharp when they are scaled up
+        FIBITMAP *image = layers[i].image;
+        if(image == nullptr)
+        {
+            continue;
+        }
+        bool scaled = FreeImage_GetWidth(image) != width || FreeImage_GetHeight(image) != height;
+        if(scaled)
+        {
+            image = FreeImage_Rescale(image, width, height, FILTER_BOX);
+        }
+
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, width, height, 1, GL_BGRA, GL_UNSIGNED_BYTE, (void*)FreeImage_GetBits(image));
+
+        if(scaled)
+        {
+            FreeImage_Unload(image);
+        }
+        FreeImage_Unload(layers[i].image);
+        layers[i].image = nullptr;
+    }
+
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void TextureArray::Bind()
+{
+    glActiveTexture(GL_TEXTURE0 + TextureUnit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+}
+
+size_t TextureArray::GetByteSize()
+{
+    // RGBA8 layers and their mipmap chains, counted once uploaded
+    return (size_t)width * height * 4 * layers.size() * 4 / 3;
+}
+
+void TextureArray::PrintReport(std::ostream &stream)
+{
+    stream << "Texture array: " << layers.size() << " layers of " << width << "x" << height << ", "
+           << GetByteSize() << " bytes" << std::endl;
+    for(size_t i = 0; i < layers.size(); ++i)
+    {
+        stream << "  " << i << " " << layers[i].path << std::endl;
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+#include <GL/glew.h>
+#include <FreeImage.h>
+#include "TextureCache.h"
+
+// Textures of the block models packed as layers of one GL_TEXTURE_2D_ARRAY, so blocks of every tile
+// variant sample the same texture and can share a draw. Images are collected while the models load and
+// uploaded together, scaled to the largest one since every layer has the same size. AddLayer may be called
+// from several loading threads, Upload only from the GL thread once they are done.
+class TextureArray
+{
+public:
+    // Unit the array stays bound to, meshes with their own textures use the units from 0
+    static const unsigned int TextureUnit = 15;
+
+    TextureArray();
+    ~TextureArray();
+
+    int AddLayer(const std::string &path);
+    void Upload();
+    void Bind();
+    size_t GetByteSize();
+    void PrintReport(std::ostream &stream);
+
+private:
+    struct Layer
+    {
+        std::string path;
+        FIBITMAP *image;
+    };
+
+    std::vector<Layer> layers;
+    std::mutex mutex;
+    unsigned int texture;
+    unsigned int width;
+    unsigned int height;
+};
@@ -0,0 +1,273 @@
+#include "TextureCache.h"
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <unordered_map>
+
+namespace
+{
+    struct Entry
+    {
+        std::string path;
+        unsigned int texture;
+        int references;
+        unsigned int width;
+        unsigned int height;
+        size_t bytes;
+    };
+
+    // An image decoded ahead of its upload, done stays false while a thread is still decoding it
+    struct Decoded
+    {
+        FIBITMAP *image;
+        bool done;
+    };
+
+    std::vector<Entry> entries;
+    // Keyed by resolved path, an entry is only erased once it is done so a decoding thread can always find it
+    std::unordered_map<std::string, Decoded> decoded;
+    std::mutex mutex;
+    std::condition_variable decodeDone;
+
+    FIBITMAP* DecodeImage(const std::string &path)
+    {
+        FREE_IMAGE_FORMAT format = FreeImage_GetFileType(path.c_str());
+        FIBITMAP *image = FreeImage_Load(format, path.c_str());
+        if(image == nullptr)
+        {
+            std::cerr << "ERROR::TEXTURE_CACHE::TEXTURE_NOT_FOUND " << path << std::endl;
+            return nullptr;
+        }
+
+        FIBITMAP *converted = FreeImage_ConvertTo32Bits(image);
+        FreeImage_Unload(image);
+        return converted;
+    }
+
+    unsigned int UploadTexture(FIBITMAP *converted, unsigned int *width, unsigned int *height)
+    {
+        if(converted == nullptr)
+        {
+            *width = 0;
+            *height = 0;
+            return 0;
+        }
+
+        *width = FreeImage_GetWidth(converted);
+        *height = FreeImage_GetHeight(converted);
+
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, *width, *height, 0, GL_BGRA, GL_UNSIGNED_BYTE, (void*)FreeImage_GetBits(converted));
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        FreeImage_Unload(converted);
+        return texture;
+    }
+}
+
+void TextureCache::Prefetch(const std::string &path)
+{
+    std::string resolved = ResolvePath(path);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for(const Entry &entry : entries)
+        {
+            if(entry.path == resolved)
+            {
+                return;
+            }
+        }
+        if(decoded.count(resolved) > 0)
+        {
+            return;
+        }
+
+        decoded[resolved] = {nullptr, false};
+    }
+
+    // Decoding runs unlocked so workers decode different files at the same time
+    FIBITMAP *image = DecodeImage(resolved);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Decoded &entry = decoded.at(resolved);
+        entry.image = image;
+        entry.done = true;
+    }
+    decodeDone.notify_all();
+}
+
+unsigned int TextureCache::Acquire(const std::string &path)
+{
+    std::string resolved = ResolvePath(path);
+    std::unique_lock<std::mutex> lock(mutex);
+    // A file still being decoded is either prefetched once done, or uploaded once its claim is gone
+    decodeDone.wait(lock, [&resolved]()
+    {
+        std::unordered_map<std::string, Decoded>::const_iterator image = decoded.find(resolved);
+        return image == decoded.end() || image->second.done;
+    });
+
+    for(Entry &entry : entries)
+    {
+        if(entry.path == resolved)
+        {
+            ++entry.references;
+            return entry.texture;
+        }
+    }
+
+    FIBITMAP *image = nullptr;
+    bool prefetched = decoded.count(resolved) > 0;
+    if(prefetched)
+    {
+        image = decoded.at(resolved).image;
+    }
+    // Claimed until the upload is in entries, so a worker prefetching the same file leaves it alone
+    decoded[resolved] = {nullptr, false};
+
+    // Decoding and uploading run unlocked so workers keep prefetching meanwhile
+    lock.unlock();
+    if(!prefetched)
+    {
+        image = DecodeImage(resolved);
+    }
+
+    Entry entry;
+    entry.path = resolved;
+    entry.texture = UploadTexture(image, &entry.width, &entry.height);
+    entry.references = 1;
+    // RGBA8 and its mipmap chain, which adds a third on top of the base level
+    entry.bytes = (size_t)entry.width * entry.height * 4 * 4 / 3;
+
+    lock.lock();
+    decoded.erase(resolved);
+
+    // Another thread may have uploaded the same file while the lock was released
+    unsigned int texture = entry.texture;
+    bool inserted = false;
+    for(Entry &other : entries)
+    {
+        if(other.path == resolved)
+        {
+            ++other.references;
+            texture = other.texture;
+            inserted = true;
+            break;
+        }
+    }
+    if(!inserted)
+    {
+        entries.push_back(entry);
+    }
+    lock.unlock();
+    decodeDone.notify_all();
+
+    if(inserted && entry.texture != 0)
+    {
+        glDeleteTextures(1, &entry.texture);
+    }
+    return texture;
+}
+
+void TextureCache::Release(unsigned int texture)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for(size_t i = 0; i < entries.size(); ++i)
+    {
+        if(entries[i].texture == texture && --entries[i].references == 0)
+        {
+            glDeleteTextures(1, &entries[i].texture);
+            entries.erase(entries.begin() + i);
+            return;
+        }
+    }
+}
+
+void TextureCache::DiscardPrefetched()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    decodeDone.wait(lock, []()
+    {
+        return std::all_of(decoded.begin(), decoded.end(),
+                           [](const std::pair<const std::string, Decoded> &image) { return image.second.done; });
+    });
+
+    for(const std::pair<const std::string, Decoded> &image : decoded)
+    {
+        if(image.second.image != nullptr)
+        {
+            FreeImage_Unload(image.second.image);
+        }
+    }
+
+    if(!decoded.empty())
+    {
+        std::cout << "GAME::TEXTURE::DISCARDED " << decoded.size() << " prefetched images" << std::endl;
+    }
+    decoded.clear();
+}
+
+std::string TextureCache::ResolvePath(const std::string &path)
+{
+    // Material files use either slash, and "dir/../" is dropped so one file always has one key
+    std::vector<std::string> parts;
+    std::string part;
+    for(size_t i = 0; i <= path.size(); ++i)
+    {
+        if(i < path.size() && path[i] != '/' && path[i] != '\\')
+        {
+            part += path[i];
+            continue;
+        }
+
+        if(part == ".." && !parts.empty() && parts.back() != "..")
+        {
+            parts.pop_back();
+        }
+        else if(part != "." && (!part.empty() || parts.empty()))
+        {
+            parts.push_back(part);
+        }
+        part.clear();
+    }
+
+    std::string resolved;
+    for(size_t i = 0; i < parts.size(); ++i)
+    {
+        resolved += (i > 0 ? "/" : "") + parts[i];
+    }
+
+    return resolved;
+}
+
+size_t TextureCache::GetByteSize()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t bytes = 0;
+    for(const Entry &entry : entries)
+    {
+        bytes += entry.bytes;
+    }
+
+    return bytes;
+}
+
+void TextureCache::PrintReport(std::ostream &stream)
+{
+    size_t bytes = GetByteSize();
+    std::lock_guard<std::mutex> lock(mutex);
+    stream << "Texture cache: " << entries.size() << " textures, " << bytes << " bytes" << std::endl;
+    for(const Entry &entry : entries)
+    {
+        stream << "  " << entry.path << " " << entry.width << "x" << entry.height << ", "
+               << entry.bytes << " bytes, " << entry.references << " references" << std::endl;
+    }
+}
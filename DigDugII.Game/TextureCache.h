@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <GL/glew.h>
+#include <FreeImage.h>
+
+// Textures shared by every model in the process, keyed by their resolved file path. A texture is decoded
+// and uploaded on its first use and deleted when the last model holding it releases it. Prefetch may run
+// on any thread and only decodes, everything else belongs to the GL thread. DiscardPrefetched frees the
+// images that were decoded but never acquired.
+namespace TextureCache
+{
+    void Prefetch(const std::string &path);
+    unsigned int Acquire(const std::string &path);
+    void Release(unsigned int texture);
+    void DiscardPrefetched();
+    std::string ResolvePath(const std::string &path);
+    size_t GetByteSize();
+    void PrintReport(std::ostream &stream);
+}
@@ -0,0 +1,143 @@
+#include "TileGrid.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+TileGrid::TileGrid()
+    : width(0),
+    height(0),
+    wordsPerRow(0)
+{
+}
+
+TileGrid::~TileGrid()
+{
+}
+
+void TileGrid::Resize(int width, int height)
+{
+    this->width = width;
+    this->height = height;
+    wordsPerRow = (width + WordBits - 1) / WordBits;
+
+    unsigned char empty = (GameObject::OBJECT_NULL << 4) | GameObject::OBJECT_NULL;
+    cells.assign(width * height, empty);
+    for(int layer = 0; layer < Layers; ++layer)
+    {
+        grassRows[layer].assign(wordsPerRow * height, 0);
+        openRows[layer].assign(wordsPerRow * height, 0);
+    }
+}
+
+int TileGrid::GetWidth()
+{
+    return width;
+}
+
+int TileGrid::GetHeight()
+{
+    return height;
+}
+
+GameObject::Object TileGrid::Get(int layer, int x, int z)
+{
+    if(!IsInside(x, z))
+    {
+        return GameObject::OBJECT_NULL;
+    }
+
+    return (GameObject::Object)((cells[z * width + x] >> (layer * 4)) & 0xF);
+}
+
+void TileGrid::Set(int layer, int x, int z, GameObject::Object object)
+{
+    unsigned char &cell = cells[z * width + x];
+    cell = (cell & ~(0xF << (layer * 4))) | (object << (layer * 4));
+
+    SetBit(grassRows[layer], x, z, object == GameObject::GRASS);
+    SetBit(openRows[layer], x, z, object == GameObject::HOLE || object == GameObject::CRACK);
+}
+
+bool TileGrid::IsInside(int x, int z)
+{
+    return x >= 0 && x < width && z >= 0 && z < height;
+}
+
+bool TileGrid::IsOpen(int layer, int x, int z)
+{
+    GameObject::Object object = Get(layer, x, z);
+    return object == GameObject::HOLE || object == GameObject::CRACK;
+}
+
+void TileGrid::FindStrandedTiles(int layer, std::vector<int> *tiles)
+{
+    // A hole or crack is stranded when none of its eight neighbours is grass
+    for(int z = 0; z < height; ++z)
+    {
+        for(int word = 0; word < wordsPerRow; ++word)
+        {
+            unsigned long long stranded = openRows[layer][z * wordsPerRow + word] & ~GetGrassAround(layer, word, z);
+            while(stranded != 0)
+            {
+                int x = word * WordBits + CountTrailingZeros(stranded);
+                tiles->push_back(z * width + x);
+                stranded &= stranded - 1;
+            }
+        }
+    }
+}
+
+void TileGrid::SetBit(std::vector<unsigned long long> &rows, int x, int z, bool value)
+{
+    unsigned long long &word = rows[z * wordsPerRow + x / WordBits];
+    unsigned long long bit = 1ULL << (x % WordBits);
+    if(value)
+    {
+        word |= bit;
+    }
+    else
+    {
+        word &= ~bit;
+    }
+}
+
+unsigned long long TileGrid::GetGrassAround(int layer, int word, int z)
+{
+    // Grass of the rows above, below and the row itself, smeared one tile left and right across word boundaries
+    unsigned long long around = 0;
+    for(int row = z - 1; row <= z + 1; ++row)
+    {
+        if(row < 0 || row >= height)
+        {
+            continue;
+        }
+
+        const unsigned long long *grass = &grassRows[layer][row * wordsPerRow];
+        unsigned long long previous = word > 0 ? grass[word - 1] : 0;
+        unsigned long long next = word + 1 < wordsPerRow ? grass[word + 1] : 0;
+
+        around |= grass[word] | (grass[word] << 1) | (previous >> (WordBits - 1)) | (grass[word] >> 1) | (next << (WordBits - 1));
+    }
+
+    return around;
+}
+
+int TileGrid::CountTrailingZeros(unsigned long long bits)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return (int)index;
+#elif defined(_MSC_VER)
+    unsigned long index;
+    if(_BitScanForward(&index, (unsigned long)bits))
+    {
+        return (int)index;
+    }
+    _BitScanForward(&index, (unsigned long)(bits >> 32));
+    return (int)index + 32;
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
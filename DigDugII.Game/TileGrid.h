@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include "GameObject.h"
+
+// Compact copy of the level grid holding only the object type of every tile. Each cell packs the
+// ground layer in its low four bits and the above layer in its high four bits, and grass and
+// hole/crack tiles are mirrored into per-row bitboards so neighbourhood scans run a word at a time.
+class TileGrid
+{
+public:
+    TileGrid();
+    ~TileGrid();
+
+    void Resize(int width, int height);
+
+    int GetWidth();
+    int GetHeight();
+    GameObject::Object Get(int layer, int x, int z);
+    void Set(int layer, int x, int z, GameObject::Object object);
+
+    bool IsInside(int x, int z);
+    bool IsOpen(int layer, int x, int z);
+    void FindStrandedTiles(int layer, std::vector<int> *tiles);
+
+private:
+    static const int Layers = 2;
+    static const int WordBits = 64;
+
+    int width;
+    int height;
+    int wordsPerRow;
+    std::vector<unsigned char> cells;
+    std::vector<unsigned long long> grassRows[Layers];
+    std::vector<unsigned long long> openRows[Layers];
+
+    void SetBit(std::vector<unsigned long long> &rows, int x, int z, bool value);
+    unsigned long long GetGrassAround(int layer, int word, int z);
+    static int CountTrailingZeros(unsigned long long bits);
+};
@@ -23,12 +23,14 @@ struct Light {
 in vec2 TexCoords;
 in vec3 FragPosition;
 in vec3 Normal;
+flat in float Layer;
 
 out vec4 color;
 
 uniform vec3 viewPosition;
 uniform Light lights[LIGHT_COUNT];
 uniform Material material;
+uniform sampler2DArray blockTextures;
 
 vec3 CalcLight(Light light, Material mat, vec3 normal, vec3 fragPosition, vec3 viewDirection)
 {
@@ -41,10 +43,23 @@ vec3 CalcLight(Light light, Material mat, vec3 normal, vec3 fragPosition, vec3 v
     // Attenuation
     float distance = length(light.position - FragPosition);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+    // Blocks sample their layer of the texture array, other meshes their own textures
+    vec3 diffuseColor;
+    vec3 specularColor;
+    if(Layer >= 0.0)
+    {
+        diffuseColor = vec3(texture(blockTextures, vec3(TexCoords, Layer)));
+        specularColor = diffuseColor;
+    }
+    else
+    {
+        diffuseColor = vec3(texture(mat.texture_diffuse1, TexCoords));
+        specularColor = vec3(texture(mat.texture_specular1, TexCoords));
+    }
     // Combine results
-    vec3 ambient = light.ambient * vec3(texture(mat.texture_diffuse1, TexCoords));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(mat.texture_diffuse1, TexCoords));
-    vec3 specular = light.specular * spec * vec3(texture(mat.texture_specular1, TexCoords));
+    vec3 ambient = light.ambient * diffuseColor;
+    vec3 diffuse = light.diffuse * diff * diffuseColor;
+    vec3 specular = light.specular * spec * specularColor;
     ambient *= attenuation;
     diffuse *= attenuation;
     specular *= attenuation;
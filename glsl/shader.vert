@@ -3,12 +3,15 @@
 in vec3 position;
 in vec3 normal;
 in vec2 texCoords;
+in mat4 model;
+in float layer;
+in mat3 normalMatrix;
 
 out vec2 TexCoords;
 out vec3 FragPosition;
 out vec3 Normal;
+flat out float Layer;
 
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
@@ -16,6 +19,7 @@ void main()
 {
     gl_Position = projection * view * model * vec4(position, 1.0f);
     FragPosition = vec3(model * vec4(position, 1.0f));
-    Normal = mat3(transpose(inverse(model))) * normal;
+    Normal = normalMatrix * normal;
     TexCoords = texCoords;
+    Layer = layer;
 }